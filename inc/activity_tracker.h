@@ -0,0 +1,57 @@
+#ifndef _ACTIVITY_TRACKER_H_
+#define _ACTIVITY_TRACKER_H_
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include <globals.h>
+#include <message_batch.h>
+#include <token_map.h>
+
+/*
+ * Keeps the time of the last message event of every process and turns the
+ * message events into the gaps between them. Each gap is computed once and
+ * handed to all subscribed analyses (idle statistics, inactivity histograms)
+ * batch-wise. The first gap of a process is measured from time 0.
+ *
+ * A shard holds back the first gap of each process until it is merged, as
+ * only then the last event of the previous part is known.
+ */
+class ActivityTracker {
+public:
+	// gaps of one process in order of arrival, with the type of the event ending each
+	struct Gaps {
+		std::vector<uint64_t> gap  {};
+		std::vector<uint8_t>  type {};
+	};
+	using Subscriber = std::function<void(uint32_t proc, const Gaps &gaps)>;
+
+private:
+	struct Activity {
+		uint64_t first      {0}; // time of the first event, if held back
+		uint8_t  first_type {0};
+		uint64_t last       {0};
+		bool     active     {false};
+	};
+
+	bool is_shard {false};
+	TokenMap<Activity> activity {};
+	std::vector<Subscriber> subscribers {};
+	Gaps gaps {}; // reused for every batch
+
+	void publish(uint32_t proc);
+
+public:
+	ActivityTracker(std::shared_ptr<const TokenIndex> procs, bool shard=false);
+	~ActivityTracker();
+
+	void subscribe(Subscriber s);
+	void addMessageBatch(uint32_t proc, const MessageBatch &batch);
+
+	void merge(const ActivityTracker &other);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef _CALL_TREE_H_
+#define _CALL_TREE_H_
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+#include <globals.h>
+
+/*
+ * Calling-context tree of one process: a node per distinct call path with
+ * the calls, inclusive and exclusive time (ns) of that path.
+ * Nodes are allocated from blocks that never move and are referred to by
+ * index. The first children of a node are kept in the node itself, further
+ * ones in chained overflow blocks.
+ *
+ * Calls made while the call stack is empty hang below a base node, nothing
+ * is allocated before the first one. A part of the trace that starts inside
+ * a call (a time slice) gets a new base for every leave of a call it did not
+ * enter, the merge with the preceding part moves these subtrees to the call
+ * that was open there.
+ */
+class CallTree {
+public:
+	enum : uint32_t { none = 0xffffffff };
+	enum : uint32_t { inline_children = 4, overflow_children = 8 };
+
+	struct Node {
+		uint32_t func   {none};
+		uint32_t parent {none};
+		uint64_t calls  {0};
+		uint64_t incl   {0};
+		uint64_t excl   {0};
+		uint32_t child[inline_children] {none, none, none, none};
+		uint32_t more   {none}; // overflow block with further children
+	};
+
+private:
+	enum : uint32_t { block_bits = 8, block_size = 1u << block_bits };
+
+	struct ChildBlock {
+		uint32_t child[overflow_children] {none, none, none, none, none, none, none, none};
+		uint32_t next {none};
+	};
+
+	std::vector<std::vector<Node>> blocks {}; // reserved to block_size, so nodes stay in place
+	uint32_t nodes {0};
+	std::vector<ChildBlock> overflow {};
+	std::vector<uint32_t> bases {};
+
+	uint32_t alloc(uint32_t parent, uint32_t func);
+
+public:
+	Node&       node(uint32_t n)       { return blocks[n >> block_bits][n & (block_size-1)]; }
+	const Node& node(uint32_t n) const { return blocks[n >> block_bits][n & (block_size-1)]; }
+	uint32_t    size(void) const       { return nodes; }
+
+	// node of a call of func made from parent, created on first use
+	uint32_t child(uint32_t parent, uint32_t func);
+
+	// base for the calls after the given number of leaves without enter
+	uint32_t base(size_t epoch);
+	uint32_t findBase(size_t epoch) const { return epoch < bases.size() ? bases[epoch] : none; }
+	size_t   numBases(void) const         { return bases.size(); }
+
+	// adds the subtree below other_node to the one below n, map receives the
+	// index of every copied node of other in this tree
+	void graft(uint32_t n, const CallTree &other, uint32_t other_node, std::vector<uint32_t> &map);
+
+	// calls f(child) for all children of a node
+	template<typename F>
+	void forEachChild(uint32_t n, F f) const
+	{
+		const Node &p = node(n);
+		for (uint32_t i=0; i<inline_children && p.child[i] != none; i++)
+			f(p.child[i]);
+
+		for (uint32_t b=p.more; b != none; b=overflow[b].next)
+			for (uint32_t i=0; i<overflow_children && overflow[b].child[i] != none; i++)
+				f(overflow[b].child[i]);
+	}
+};
+
+#endif
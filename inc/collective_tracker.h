@@ -0,0 +1,112 @@
+#ifndef _COLLECTIVE_TRACKER_H_
+#define _COLLECTIVE_TRACKER_H_
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include <globals.h>
+#include <token_map.h>
+#include <flat_hash_map.h>
+
+/*
+ * Collects the participants of collective operation instances, tied
+ * together by the matching id of their begin and end records. An instance
+ * is complete when all members of its communicator have left it; it is then
+ * handed to the subscribed analyses and dropped, so only the instances in
+ * progress are kept. Instances of communicators of unknown size are kept
+ * until finish().
+ *
+ * The instances in progress are found by matching id in a FlatHashMap.
+ * Every process keeps the few instances it has entered but not left.
+ *
+ * A part of the trace that starts inside a collective keeps the ends of
+ * instances it did not see begin, the merge with the preceding part
+ * resolves them. A shard reading whole processes (own()) hands the
+ * participants of its processes to the merge as soon as they have left,
+ * the merge completes the instance from the parts of all shards.
+ */
+class CollectiveTracker {
+public:
+	struct Participant {
+		uint32_t proc;
+		uint64_t enter; // ticks
+		uint64_t exit;
+	};
+
+	struct Instance {
+		uint64_t id       {0};
+		uint32_t comm     {0};
+		uint32_t op       {0};
+		uint32_t expected {0}; // members of the communicator, 0 if unknown
+		uint32_t open     {0}; // participants that did not leave yet
+		std::vector<Participant> participants {};
+	};
+	using Subscriber = std::function<void(const Instance &instance)>;
+
+private:
+	struct IdHash {
+		uint64_t operator()(uint64_t id) const { return mix64(id); }
+	};
+
+	// collective a process has entered but not left
+	struct Entered {
+		uint64_t id;
+		uint32_t participant;
+	};
+
+	// end of a collective entered before the part of the trace read here
+	struct OpenEnd {
+		uint32_t proc;
+		uint64_t id;
+		uint64_t time;
+	};
+
+	// participants of an instance left in processes owned by the shard
+	struct Part {
+		uint64_t id;
+		uint32_t comm;
+		uint32_t op;
+		uint32_t expected;
+		uint32_t first; // in part_participants
+		uint32_t n;
+	};
+
+	FlatHashMap<uint64_t, uint32_t, IdHash> ids {}; // matching id -> instance
+	FlatHashMap<uint64_t, uint32_t, IdHash> owned_members {64}; // comm -> members
+	std::vector<Part> parts {};
+	std::vector<Participant> part_participants {};
+	std::vector<Instance> instances {};
+	std::vector<uint32_t> free_instances {};
+	TokenMap<std::vector<Entered>> entered {};
+	std::vector<OpenEnd> open_ends {};
+	std::vector<Subscriber> subscribers {};
+
+	uint32_t instance(uint64_t id, uint32_t comm, uint32_t op, uint32_t expected);
+	void     complete(uint64_t id, bool force=false);
+	bool     leave(uint32_t proc, uint64_t id, uint64_t time);
+
+public:
+	CollectiveTracker(std::shared_ptr<const TokenIndex> procs);
+	~CollectiveTracker();
+
+	void subscribe(Subscriber s);
+	// members: per communicator, the processes the shard reads all events of from now on
+	void own(const std::map<uint32_t, uint32_t> &members);
+	void addBegin(uint32_t proc, uint64_t time, uint64_t id, uint32_t comm, uint32_t op, uint32_t expected);
+	void addEnd(uint32_t proc, uint64_t time, uint64_t id);
+
+	void merge(const CollectiveTracker &other);
+
+	// hands over the instances all participants of which have left, after reading
+	void finish(void);
+
+	// instances with participants that did not leave, ends without begin
+	uint64_t unfinishedInstances(void) const { return ids.size(); }
+	uint64_t unmatchedEnds(void) const       { return open_ends.size(); }
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _COMM_MATRIX_H_
+#define _COMM_MATRIX_H_
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+#include <globals.h>
+#include <token_map.h>
+
+/*
+ * Sparse process-to-process matrix of messages and bytes. Every row keeps
+ * its cells sorted by column; new cells are appended unsorted and merged in
+ * once the tail has grown to the size of the sorted part (at least 64), so
+ * adding stays cheap and the memory follows the pairs that communicate.
+ * The rows are compacted to CSR when written.
+ *
+ * Binary format (native byte order):
+ *   char     magic[8]   "SONARCM1"
+ *   uint64_t n          processes (rows = columns)
+ *   uint64_t nnz        non-zero cells
+ *   uint32_t procs[n]   process id of every row/column
+ *   uint64_t rows[n+1]  offset of the first cell of every row
+ *   uint32_t cols[nnz]  column index
+ *   uint64_t msgs[nnz]
+ *   uint64_t bytes[nnz]
+ */
+class CommMatrix {
+public:
+	struct Cell {
+		uint32_t col;
+		uint64_t msgs;
+		uint64_t bytes;
+	};
+
+private:
+	struct Row {
+		std::vector<Cell> sorted {};
+		std::vector<Cell> tail   {};
+	};
+	TokenMap<Row> rows {};
+
+	static void compact(Row &row);
+
+public:
+	CommMatrix() {}
+	explicit CommMatrix(std::shared_ptr<const TokenIndex> procs) : rows(procs) {}
+
+	void add(uint32_t row, uint32_t col, uint64_t msgs, uint64_t bytes)
+	{
+		auto &r = rows[row];
+		r.tail.push_back({col, msgs, bytes});
+		if (r.tail.size() >= 64 && r.tail.size() >= r.sorted.size())
+			compact(r);
+	}
+
+	void merge(const CommMatrix &other);
+	bool empty(void) const { return rows.empty(); }
+
+	void writeBinary(const std::string &filename);
+	// dense bytes with process ids as row and column headers, for small traces
+	void writeCsv(const std::string &filename);
+};
+
+#endif
@@ -6,6 +6,8 @@
 #include <stdexcept>
 
 #include <ctime>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <errno.h>
 #include <sys/stat.h>
@@ -20,6 +22,29 @@ private:
 	bool        _rawotf         { false };
 	bool        _progress       { false };
 	bool        _stats_toscreen { false };
+	uint32_t    _threads        { 1 };
+	uint32_t    _slices         { 1 };
+	bool        _unsorted       { false };
+	bool        _summary_only   { false };
+	bool        _functions      { true };
+	bool        _messages       { true };
+	bool        _collectives    { true };
+	bool        _plots          { true };
+	bool        _cache          { false };
+	bool        _pipeline       { false };
+	uint32_t    _iahist_bins    { 50 };
+	double      _iahist_max     { 500.0 }; // us
+	bool        _iahist_log     { false };
+	bool        _iahist_raw     { false };
+	uint32_t    _inj_bins       { 0 };
+	bool        _exact_sizes    { false };
+	uint32_t    _ctr_bins       { 0 };
+	bool        _cct            { false };
+	bool        _comm_matrix    { false };
+	bool        _wait_states    { false };
+	uint32_t    _call_sites     { 0 };
+	bool        _rma            { false };
+	bool        _file_io        { false };
 
 	std::string _tracename      {""};
 	std::string _resdir         {""};
@@ -31,6 +56,29 @@ public:
 	const decltype(_rawotf)			&rawotf         = _rawotf;
 	const decltype(_progress)		&progress       = _progress;
 	const decltype(_stats_toscreen)	&stats_toscreen = _stats_toscreen;
+	const decltype(_threads)		&threads        = _threads;
+	const decltype(_slices)			&slices         = _slices;
+	const decltype(_unsorted)		&unsorted       = _unsorted;
+	const decltype(_summary_only)	&summary_only   = _summary_only;
+	const decltype(_functions)		&functions      = _functions;
+	const decltype(_messages)		&messages       = _messages;
+	const decltype(_collectives)	&collectives    = _collectives;
+	const decltype(_plots)			&plots          = _plots;
+	const decltype(_cache)			&cache          = _cache;
+	const decltype(_pipeline)		&pipeline       = _pipeline;
+	const decltype(_iahist_bins)	&iahist_bins    = _iahist_bins;
+	const decltype(_iahist_max)		&iahist_max     = _iahist_max;
+	const decltype(_iahist_log)		&iahist_log     = _iahist_log;
+	const decltype(_iahist_raw)		&iahist_raw     = _iahist_raw;
+	const decltype(_inj_bins)		&inj_bins       = _inj_bins;
+	const decltype(_exact_sizes)	&exact_sizes    = _exact_sizes;
+	const decltype(_ctr_bins)		&ctr_bins       = _ctr_bins;
+	const decltype(_cct)			&cct            = _cct;
+	const decltype(_comm_matrix)	&comm_matrix    = _comm_matrix;
+	const decltype(_wait_states)	&wait_states    = _wait_states;
+	const decltype(_call_sites)		&call_sites     = _call_sites;
+	const decltype(_rma)			&rma            = _rma;
+	const decltype(_file_io)		&file_io        = _file_io;
 
 	const decltype(_tracename)		&tracename      = _tracename;
 	const decltype(_resdir)		    &resdir         = _resdir;
@@ -0,0 +1,128 @@
+#ifndef _EVENT_CACHE_H_
+#define _EVENT_CACHE_H_
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <stdexcept>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <globals.h>
+#include <config.h>
+#include <event_record.h>
+
+/*
+ * Columnar on-disk cache of the decoded events of a trace.
+ *
+ * The cache is a directory next to the trace with one file per process.
+ * A file consists of blocks, every block holds the events of the process
+ * in time order as one column per field of EventRecord.
+ */
+class EventCache {
+public:
+	static const uint32_t version    {4};
+	static const uint64_t block_size {64*1024}; // events per block
+
+	// read-only view of one block of a mapped file
+	struct Columns {
+		uint64_t        n    {0};
+		const uint8_t  *kind {nullptr};
+		const uint64_t *time {nullptr};
+		const uint32_t *a    {nullptr};
+		const uint32_t *b    {nullptr};
+		const uint32_t *c    {nullptr};
+		const uint32_t *s    {nullptr};
+		const uint64_t *v    {nullptr};
+		const uint64_t *w    {nullptr};
+		const uint64_t *m    {nullptr};
+	};
+
+	// RAII wrapper of a memory-mapped process file
+	class Mapping {
+	private:
+		void    *addr     {MAP_FAILED};
+		size_t   size     {0};
+		uint32_t _process {0};
+		std::vector<Columns> _blocks {};
+	public:
+		Mapping(const std::string &filename);
+		Mapping(const Mapping&) = delete;
+		Mapping& operator=(const Mapping&) = delete;
+		~Mapping();
+
+		const uint32_t             &process = _process;
+		const std::vector<Columns> &blocks  = _blocks;
+	};
+
+private:
+	struct Block {
+		std::vector<uint8_t>  kind {};
+		std::vector<uint64_t> time {};
+		std::vector<uint32_t> a    {};
+		std::vector<uint32_t> b    {};
+		std::vector<uint32_t> c    {};
+		std::vector<uint32_t> s    {};
+		std::vector<uint64_t> v    {};
+		std::vector<uint64_t> w    {};
+		std::vector<uint64_t> m    {};
+		uint64_t total {0}; // events of the process written so far
+	};
+
+	std::string dirname;
+	std::map<uint32_t, Block> pending {};
+	bool failed {false};
+
+	void add(uint32_t proc, EventKind kind, uint64_t time, uint32_t a, uint32_t b, uint32_t c, uint32_t s, uint64_t v, uint64_t w, uint64_t m);
+	void flush(uint32_t proc, Block &block);
+
+public:
+	EventCache(const std::string &dir);
+	~EventCache();
+
+	const decltype(dirname) &dir = dirname;
+
+	void addEnter(uint32_t proc, uint64_t time, uint32_t func, uint32_t source);
+	void addLeave(uint32_t proc, uint64_t time, uint32_t func, uint32_t source);
+	void addSend(uint32_t proc, uint64_t time, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source);
+	void addRecv(uint32_t proc, uint64_t time, uint32_t sender, uint32_t group, uint32_t type, uint32_t length, uint32_t source);
+	void addCounter(uint32_t proc, uint64_t time, uint32_t counter, uint64_t value);
+	void addBeginCollop(uint32_t proc, uint64_t time, uint32_t op, uint64_t matchingId, uint32_t group, uint32_t root, uint64_t sent, uint64_t recv, uint32_t source);
+	void addEndCollop(uint32_t proc, uint64_t time, uint64_t matchingId);
+	void addRmaPut(uint32_t proc, uint64_t time, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source);
+	void addRmaPutRemoteEnd(uint32_t proc, uint64_t time, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source);
+	void addRmaGet(uint32_t proc, uint64_t time, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source);
+	void addRmaEnd(uint32_t proc, uint64_t time, uint32_t remote, uint32_t comm, uint32_t tag, uint32_t source);
+	void addFileOp(uint32_t proc, uint64_t time, uint32_t file, uint64_t handle, uint32_t op, uint64_t bytes, uint64_t duration, uint32_t source);
+	void addBeginFileOp(uint32_t proc, uint64_t time, uint64_t matchingId, uint32_t source);
+	void addEndFileOp(uint32_t proc, uint64_t time, uint32_t file, uint64_t matchingId, uint64_t handle, uint32_t op, uint64_t bytes, uint32_t source);
+
+	// writes all pending blocks, returns the written processes and their number of events
+	std::map<uint32_t, uint64_t> close(void);
+	bool ok(void) { return !failed; }
+
+	// cache directory handling
+	static std::string location(const std::string &otffile);
+	static std::string filename(const std::string &dir, uint32_t proc);
+	static bool        isValid(const std::string &dir, const std::string &otffile);
+	static std::vector<uint32_t> processes(const std::string &dir);
+	static uint64_t    events(const std::string &dir);
+	static bool        prepare(const std::string &dir);
+	static bool        commit(const std::string &tmpdir, const std::string &dir, const std::string &otffile, uint64_t events, const std::map<uint32_t, uint64_t> &procs);
+	static void        remove(const std::string &dir);
+};
+
+#endif
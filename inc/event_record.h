@@ -0,0 +1,85 @@
+#ifndef _EVENT_RECORD_H_
+#define _EVENT_RECORD_H_
+
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
+/*
+ * Event records decoded into plain structs, used by the event cache and
+ * the pipelined reader. Which fields a record kind uses:
+ *
+ *   ENTER, LEAVE  : a=function, s=source
+ *   SEND          : a=receiver, b=group, c=type, v=length, s=source
+ *   RECV          : a=sender,   b=group, c=type, v=length, s=source
+ *   COUNTER       : a=counter, v=value
+ *   BEGIN_COLLOP  : a=operation, b=group, c=root, v=sent, w=received, m=matchingId, s=source
+ *   END_COLLOP    : m=matchingId
+ *   RMA_PUT, RMA_PUT_RE, RMA_GET : a=origin, b=target, c=communicator, v=bytes, w=tag, s=source
+ *   RMA_END       : a=remote, c=communicator, w=tag, s=source
+ *   FILEOP        : a=file, c=operation, v=bytes, w=handle, m=duration, s=source
+ *   BEGIN_FILEOP  : m=matchingId, s=source
+ *   END_FILEOP    : a=file, c=operation, v=bytes, w=handle, m=matchingId, s=source
+ */
+enum EventKind : uint8_t {ENTER, LEAVE, SEND, RECV, COUNTER, BEGIN_COLLOP, END_COLLOP, RMA_PUT, RMA_PUT_RE, RMA_GET, RMA_END,
+	FILEOP, BEGIN_FILEOP, END_FILEOP};
+
+struct EventRecord {
+	uint64_t time {0};
+	uint64_t v    {0};
+	uint64_t w    {0};
+	uint64_t m    {0};
+	uint32_t proc {0};
+	uint32_t a    {0};
+	uint32_t b    {0};
+	uint32_t c    {0};
+	uint32_t s    {0};
+	uint8_t  kind {0};
+};
+
+// calls the handler of T matching the record kind
+template<typename T, typename D>
+inline int dispatch_event(D *data, uint8_t kind, uint64_t time, uint32_t proc, uint32_t a, uint32_t b, uint32_t c, uint32_t s, uint64_t v, uint64_t w, uint64_t m)
+{
+	switch (kind)
+	{
+		case ENTER:
+			return T::handleEnter(data, time, a, proc, s, nullptr);
+		case LEAVE:
+			return T::handleLeave(data, time, a, proc, s, nullptr);
+		case SEND:
+			return T::handleSendMsg(data, time, proc, a, b, c, v, s, nullptr);
+		case RECV:
+			return T::handleRecvMsg(data, time, proc, a, b, c, v, s, nullptr);
+		case COUNTER:
+			return T::handleCounter(data, time, proc, a, v, nullptr);
+		case BEGIN_COLLOP:
+			return T::handleBeginCollectiveOperation(data, time, proc, a, m, b, c, v, w, s, nullptr);
+		case END_COLLOP:
+			return T::handleEndCollectiveOperation(data, time, proc, m, nullptr);
+		case RMA_PUT:
+			return T::handleRMAPut(data, time, proc, a, b, c, w, v, s, nullptr);
+		case RMA_PUT_RE:
+			return T::handleRMAPutRemoteEnd(data, time, proc, a, b, c, w, v, s, nullptr);
+		case RMA_GET:
+			return T::handleRMAGet(data, time, proc, a, b, c, w, v, s, nullptr);
+		case RMA_END:
+			return T::handleRMAEnd(data, time, proc, a, c, w, s, nullptr);
+		case FILEOP:
+			return T::handleFileOperation(data, time, a, proc, w, c, v, m, s, nullptr);
+		case BEGIN_FILEOP:
+			return T::handleBeginFileOperation(data, time, proc, m, s, nullptr);
+		case END_FILEOP:
+			return T::handleEndFileOperation(data, time, proc, a, m, w, c, v, s, nullptr);
+		default:
+			throw std::runtime_error("Invalid event record kind " + std::to_string(kind));
+	}
+}
+
+template<typename T, typename D>
+inline int dispatch_event(D *data, const EventRecord &e)
+{
+	return dispatch_event<T>(data, e.kind, e.time, e.proc, e.a, e.b, e.c, e.s, e.v, e.w, e.m);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef _FILE_OP_TRACKER_H_
+#define _FILE_OP_TRACKER_H_
+
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include <globals.h>
+#include <flat_hash_map.h>
+
+/*
+ * Pairs the begin and end records of file operations by process and
+ * matching id. The operations in progress are kept in a FlatHashMap; a
+ * completed operation is handed to the subscribed analyses and dropped.
+ *
+ * A part of the trace that starts inside an operation keeps its end, the
+ * merge with the preceding part resolves it.
+ */
+class FileOpTracker {
+public:
+	struct Operation {
+		uint32_t proc;
+		uint32_t file;
+		uint32_t op;    // OTF_FILEOP_* with the I/O flags
+		uint64_t bytes;
+		uint64_t begin; // ticks
+		uint64_t end;
+	};
+	using Subscriber = std::function<void(const Operation &op)>;
+
+private:
+	struct Key {
+		uint32_t proc;
+		uint64_t id;
+
+		bool operator==(const Key &k) const { return proc == k.proc && id == k.id; }
+	};
+
+	struct KeyHash {
+		uint64_t operator()(const Key &k) const { return mix64(k.id ^ (static_cast<uint64_t>(k.proc) * 0x9e3779b97f4a7c15ULL)); }
+	};
+
+	// end of an operation begun before the part of the trace read here
+	struct OpenEnd {
+		uint64_t  id;
+		Operation op;
+	};
+
+	FlatHashMap<Key, uint64_t, KeyHash> begins {}; // begin time of the operations in progress
+	std::vector<OpenEnd> open_ends {};
+	std::vector<Subscriber> subscribers {};
+
+	bool complete(uint64_t id, Operation op);
+
+public:
+	FileOpTracker();
+	~FileOpTracker();
+
+	void subscribe(Subscriber s);
+	void addBegin(uint32_t proc, uint64_t time, uint64_t id);
+	void addEnd(uint32_t proc, uint64_t time, uint64_t id, uint32_t file, uint32_t op, uint64_t bytes);
+	// operation recorded as a whole
+	void addOperation(uint32_t proc, uint64_t begin, uint64_t end, uint32_t file, uint32_t op, uint64_t bytes);
+
+	void merge(const FileOpTracker &other);
+
+	// begins without end, ends without begin
+	uint64_t pendingBegins(void) const { return begins.size(); }
+	uint64_t unmatchedEnds(void) const { return open_ends.size(); }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef _FLAT_HASH_MAP_H_
+#define _FLAT_HASH_MAP_H_
+
+#include <vector>
+#include <cstdint>
+
+// splitmix64 finalizer, spreads consecutive keys (matching ids) over the table
+inline uint64_t mix64(uint64_t h)
+{
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+	return h ^ (h >> 31);
+}
+
+/*
+ * Hash map for the small, short-lived entries of the trackers (channels,
+ * instances and operations in progress): open addressing with linear
+ * probing in a power-of-two table filled to at most 70%, backward shift
+ * deletion instead of tombstones. H is a functor returning a 64 bit hash.
+ *
+ * An insertion may move all entries: references and pointers obtained
+ * before are invalid after operator[] added a key.
+ */
+template<typename K, typename V, typename H>
+class FlatHashMap {
+private:
+	static constexpr size_t npos = static_cast<size_t>(-1);
+
+	struct Slot {
+		K    key   {};
+		V    value {};
+		bool used  {false};
+	};
+
+	std::vector<Slot> slots {};
+	size_t used_slots {0};
+	size_t initial    {256};
+
+	size_t home(const K &key) const { return H()(key) & (slots.size() - 1); }
+
+	size_t find(const K &key) const
+	{
+		if (slots.empty())
+			return npos;
+
+		const size_t mask = slots.size() - 1;
+		for (size_t i=home(key); slots[i].used; i=(i + 1) & mask)
+			if (slots[i].key == key)
+				return i;
+
+		return npos;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<Slot> old(capacity);
+		old.swap(slots);
+
+		const size_t mask = slots.size() - 1;
+		for (auto &s:old)
+		{
+			if (!s.used)
+				continue;
+
+			size_t i = home(s.key);
+			while (slots[i].used)
+				i = (i + 1) & mask;
+			slots[i] = std::move(s);
+		}
+	}
+
+public:
+	// capacity: table size of the first insertion, a power of two
+	explicit FlatHashMap(size_t capacity=256) : initial(capacity) {}
+
+	size_t size(void) const  { return used_slots; }
+	bool   empty(void) const { return used_slots == 0; }
+
+	V* get(const K &key)
+	{
+		const size_t i = find(key);
+		return i != npos ? &slots[i].value : nullptr;
+	}
+
+	const V* get(const K &key) const
+	{
+		const size_t i = find(key);
+		return i != npos ? &slots[i].value : nullptr;
+	}
+
+	// value of key, default constructed on first use
+	V& operator[](const K &key)
+	{
+		const size_t found = find(key);
+		if (found != npos)
+			return slots[found].value;
+
+		if ((used_slots + 1) * 10 > slots.size() * 7)
+			rehash(slots.empty() ? initial : slots.size() * 2);
+
+		const size_t mask = slots.size() - 1;
+		size_t i = home(key);
+		while (slots[i].used)
+			i = (i + 1) & mask;
+
+		slots[i].key  = key;
+		slots[i].used = true;
+		used_slots++;
+		return slots[i].value;
+	}
+
+	bool erase(const K &key)
+	{
+		size_t i = find(key);
+		if (i == npos)
+			return false;
+
+		// move up the following entries that would not be found any more
+		const size_t mask = slots.size() - 1;
+		for (size_t j=(i + 1) & mask; slots[j].used; j=(j + 1) & mask)
+		{
+			const size_t h = home(slots[j].key);
+			const bool stays = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+			if (stays)
+				continue;
+
+			slots[i] = std::move(slots[j]);
+			i = j;
+		}
+
+		slots[i] = Slot();
+		used_slots--;
+		return true;
+	}
+
+	// calls f(key, value) for all entries in table order, which must not change meanwhile
+	template<typename F>
+	void forEach(F f) const
+	{
+		for (const auto &s:slots)
+			if (s.used)
+				f(s.key, s.value);
+	}
+};
+
+#endif
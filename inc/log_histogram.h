@@ -0,0 +1,131 @@
+#ifndef _LOG_HISTOGRAM_H_
+#define _LOG_HISTOGRAM_H_
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+/*
+ * HDR-style histogram of unsigned 64 bit values with logarithmic buckets.
+ * Values below 2^sub_bits get a bucket of their own, every larger power of
+ * two range is split into 2^sub_bits buckets, so a bucket spans at most
+ * 1/2^sub_bits of its values (relative error). Only the range of buckets
+ * in use is stored. Merging adds the bucket counts, so the result does not
+ * depend on how the values were split up.
+ */
+class LogHistogram {
+private:
+	uint32_t sub_bits {5};
+	uint32_t offset   {0};            // bucket index of counts[0]
+	std::vector<uint64_t> counts {};
+	uint64_t total    {0};
+
+	uint32_t bucket(uint64_t value) const
+	{
+		if (value < (uint64_t(1) << sub_bits))
+			return value;
+
+		uint32_t e = 63 - __builtin_clzll(value); // e >= sub_bits
+		return ((e - sub_bits + 1) << sub_bits) + (value >> (e - sub_bits)) - (uint64_t(1) << sub_bits);
+	}
+
+	void grow(uint32_t idx)
+	{
+		if (counts.empty())
+		{
+			offset = idx;
+			counts.resize(1, 0);
+		}
+		else if (idx < offset)
+		{
+			counts.insert(counts.begin(), offset - idx, 0);
+			offset = idx;
+		}
+		else if (idx - offset >= counts.size())
+		{
+			counts.resize(idx - offset + 1, 0);
+		}
+	}
+
+public:
+	LogHistogram() {}
+	explicit LogHistogram(uint32_t bits) : sub_bits(bits) {}
+
+	void add(uint64_t value, uint64_t n=1)
+	{
+		const uint32_t idx = bucket(value);
+		grow(idx);
+		counts[idx - offset] += n;
+		total += n;
+	}
+
+	void merge(const LogHistogram &other)
+	{
+		if (other.counts.empty())
+			return;
+
+		grow(other.offset);
+		grow(other.offset + other.counts.size() - 1);
+		for (size_t i=0; i<other.counts.size(); i++)
+			counts[other.offset - offset + i] += other.counts[i];
+		total += other.total;
+	}
+
+	uint64_t count(void) const { return total; }
+	bool     empty(void) const { return total == 0; }
+
+	// smallest and largest value of a bucket
+	uint64_t lower(uint32_t idx) const
+	{
+		if (idx < (uint32_t(1) << sub_bits))
+			return idx;
+
+		const uint32_t e = (idx >> sub_bits) + sub_bits - 1;
+		const uint64_t m = (idx & ((uint32_t(1) << sub_bits) - 1)) + (uint64_t(1) << sub_bits);
+		return m << (e - sub_bits);
+	}
+
+	uint64_t upper(uint32_t idx) const
+	{
+		if (idx < (uint32_t(1) << sub_bits))
+			return idx;
+
+		const uint32_t e = (idx >> sub_bits) + sub_bits - 1;
+		return lower(idx) + ((uint64_t(1) << (e - sub_bits)) - 1);
+	}
+
+	// value below which the fraction q of all values lies (bucket midpoint)
+	uint64_t quantile(double q) const
+	{
+		if (total == 0)
+			return 0;
+
+		uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+		rank = rank < 1 ? 1 : (rank > total ? total : rank);
+
+		uint64_t seen = 0;
+		for (size_t i=0; i<counts.size(); i++)
+		{
+			seen += counts[i];
+			if (seen >= rank)
+			{
+				const uint32_t idx = offset + i;
+				return lower(idx) + (upper(idx) - lower(idx)) / 2;
+			}
+		}
+
+		return upper(offset + counts.size() - 1);
+	}
+
+	// calls f(lower, upper, count) for all non-empty buckets in ascending order
+	template<typename F>
+	void forEach(F f) const
+	{
+		for (size_t i=0; i<counts.size(); i++)
+			if (counts[i] > 0)
+				f(lower(offset + i), upper(offset + i), counts[i]);
+	}
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef _MESSAGE_BATCH_H_
+#define _MESSAGE_BATCH_H_
+
+#include <vector>
+#include <initializer_list>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Message events of one process as collected by the handlers, stored as
+ * struct of arrays and handed over to TraceStats/TraceVisualizer at once.
+ */
+struct MessageBatch {
+	static const size_t capacity {1024}; // events before the batch is handed over
+
+	enum Type : uint8_t {P2P_SEND, P2P_RECV, COLLECTIVE};
+
+	struct P2P {
+		std::vector<uint64_t> time   {};
+		std::vector<uint32_t> peer   {};
+		std::vector<uint64_t> length {};
+	};
+
+	struct Collective {
+		std::vector<uint64_t> time {};
+		std::vector<uint32_t> comm {};
+		std::vector<uint32_t> op   {};
+		std::vector<uint64_t> sent {};
+		std::vector<uint64_t> recv {};
+	};
+
+	P2P        send {};
+	P2P        recv {};
+	Collective coll {};
+
+	// type of every event in order of arrival, interleaves the arrays above
+	std::vector<uint8_t> order {};
+
+	void addSend(uint64_t time, uint32_t receiver, uint64_t length)
+	{
+		send.time.push_back(time);
+		send.peer.push_back(receiver);
+		send.length.push_back(length);
+		order.push_back(P2P_SEND);
+	}
+
+	void addRecv(uint64_t time, uint32_t sender, uint64_t length)
+	{
+		recv.time.push_back(time);
+		recv.peer.push_back(sender);
+		recv.length.push_back(length);
+		order.push_back(P2P_RECV);
+	}
+
+	void addColl(uint64_t time, uint32_t comm, uint32_t op, uint64_t sent, uint64_t received)
+	{
+		coll.time.push_back(time);
+		coll.comm.push_back(comm);
+		coll.op.push_back(op);
+		coll.sent.push_back(sent);
+		coll.recv.push_back(received);
+		order.push_back(COLLECTIVE);
+	}
+
+	size_t size(void) const { return order.size(); }
+
+	// calls f(time, type) for all events in order of arrival
+	template<typename F>
+	void forEach(F f) const
+	{
+		size_t s = 0, r = 0, c = 0;
+		for (auto type:order)
+		{
+			switch (type)
+			{
+				case P2P_SEND:   f(send.time[s++], type); break;
+				case P2P_RECV:   f(recv.time[r++], type); break;
+				case COLLECTIVE: f(coll.time[c++], type); break;
+			}
+		}
+	}
+
+	void clear(void)
+	{
+		for (auto p:{&send, &recv})
+		{
+			p->time.clear();
+			p->peer.clear();
+			p->length.clear();
+		}
+
+		coll.time.clear();
+		coll.comm.clear();
+		coll.op.clear();
+		coll.sent.clear();
+		coll.recv.clear();
+
+		order.clear();
+	}
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef _MESSAGE_MATCHER_H_
+#define _MESSAGE_MATCHER_H_
+
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include <globals.h>
+#include <flat_hash_map.h>
+
+/*
+ * Pairs the sends of point-to-point messages with their receives. Messages
+ * between the same processes on the same communicator with the same tag do
+ * not overtake each other (MPI), so the n-th send of such a channel belongs
+ * to its n-th receive. This does not depend on how the events of different
+ * processes are interleaved, no global time order is needed.
+ *
+ * The channels are kept in a FlatHashMap, the messages waiting for their counterpart in FIFO queues of pooled nodes.
+ * Every match is handed to the subscribed analyses once.
+ *
+ * A shard queues the messages until it is merged, as the messages left open
+ * by the preceding part of the trace are not known yet. Only the channels
+ * between processes it owns (reads all events of, see own()) are matched
+ * right away.
+ */
+class MessageMatcher {
+public:
+	struct Match {
+		uint32_t sender;
+		uint32_t receiver;
+		uint64_t send_time; // ticks
+		uint64_t recv_time;
+		uint64_t length;
+		uint64_t send_region; // as passed with the events
+		uint64_t recv_region;
+	};
+	using Subscriber = std::function<void(const Match &match)>;
+
+private:
+	enum : uint32_t { none = 0xffffffff };
+
+	struct Key {
+		uint32_t sender;
+		uint32_t receiver;
+		uint32_t comm;
+		uint32_t tag;
+
+		bool operator==(const Key &k) const
+		{
+			return sender == k.sender && receiver == k.receiver && comm == k.comm && tag == k.tag;
+		}
+	};
+
+	struct Pending {
+		uint64_t time;
+		uint64_t length;
+		uint64_t region;
+		uint32_t next;
+	};
+
+	struct Queue {
+		uint32_t head {none};
+		uint32_t tail {none};
+		bool empty(void) const { return head == none; }
+	};
+
+	struct KeyHash {
+		uint64_t operator()(const Key &k) const;
+	};
+
+	struct ProcHash {
+		uint64_t operator()(uint32_t proc) const { return mix64(proc); }
+	};
+
+	struct Channel {
+		Queue send {};
+		Queue recv {};
+		bool  local {false}; // both processes owned
+	};
+
+	bool is_shard {false};
+	FlatHashMap<Key, Channel, KeyHash> channels {1024};
+	FlatHashMap<uint32_t, bool, ProcHash> owned {64};
+	std::vector<Pending> pool {};
+	uint32_t free_nodes {none};
+	uint64_t pending_sends {0};
+	uint64_t pending_recvs {0};
+	std::vector<Subscriber> subscribers {};
+
+	void     push(Queue &q, uint64_t time, uint64_t length, uint64_t region);
+	Pending  pop(Queue &q);
+	void     match(const Key &k, Channel &c);
+	bool     matches(const Key &k, Channel &c);
+
+public:
+	MessageMatcher(bool shard=false);
+	~MessageMatcher();
+
+	void subscribe(Subscriber s);
+	// the shard gets all events of proc, from its first one on
+	void own(uint32_t proc);
+	// region: opaque value handed over with the match (e.g. enter of the MPI call)
+	void addSend(uint64_t time, uint32_t sender, uint32_t receiver, uint32_t comm, uint32_t tag, uint64_t length, uint64_t region=0);
+	void addRecv(uint64_t time, uint32_t receiver, uint32_t sender, uint32_t comm, uint32_t tag, uint64_t length, uint64_t region=0);
+
+	void merge(const MessageMatcher &other);
+
+	// messages without counterpart (so far)
+	uint64_t pendingSends(void) const { return pending_sends; }
+	uint64_t pendingRecvs(void) const { return pending_recvs; }
+};
+
+#endif
@@ -6,10 +6,27 @@
 #include <otf_handler.h>
 #include <trace_stats.h>
 #include <trace_visualizer.h>
-
-template <typename T>
+#include <message_batch.h>
+#include <sonar_modules.h>
+
+/*
+ * Handlers of the trace records, T is the user data. The definitions, the
+ * summaries and the message batches are handled here, the events are passed
+ * on to the analysis modules (sonar_modules.h).
+ */
+template <typename T, typename... Modules>
 class Sonar : public OTF_Handler {
+private:
+	// calls a hook of every module in order: each{0, (Modules::hook(...), 0)...}
+	using each = int[];
+
+	// message events are only batched for modules taking the batches
+	static constexpr bool batched = (SonarFeatures<Modules...>::value() & SONAR_BATCHED) != 0;
+
 public:
+	// optional analyses covered by this instantiation
+	static constexpr uint32_t features(void) { return SonarFeatures<Modules...>::value(); }
+
 	Sonar()
 	{
 		ctor_msg(__PRETTY_FUNCTION__);
@@ -20,6 +37,34 @@ public:
 		dtor_msg(__PRETTY_FUNCTION__);
 	}
 
+	//
+	// message events are collected per process and handed over in batches
+	//
+
+	// the events of a process come in runs, only a new process is looked up
+	static MessageBatch& getBatch(T *data, uint32_t proc)
+	{
+		if (proc != data->batch_proc)
+		{
+			data->batch      = &data->batches[proc];
+			data->batch_proc = proc;
+		}
+		return *data->batch;
+	}
+
+	static void flushBatch(T *data, uint32_t proc, MessageBatch &batch)
+	{
+		each{0, (Modules::onMessageBatch(data, proc, batch), 0)...};
+		batch.clear();
+	}
+
+	// must be called after reading the events, before the results are used
+	static void flushBatches(T *data)
+	{
+		for (auto &b:data->batches)
+			flushBatch(data, b.first, b.second);
+	}
+
 	//
 	// specific handler implementations
 	//
@@ -112,6 +157,34 @@ public:
 		return OTF_RETURN_OK;
 	}
 
+	static int handleDefScl(void* userData, uint32_t stream, uint32_t source, uint32_t sourceFile, uint32_t line, OTF_KeyValueList *list)
+	{
+		((T*)userData)->ts->addScl(source, sourceFile, line);
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleDefSclFile(void* userData, uint32_t stream, uint32_t sourceFile, const char* name, OTF_KeyValueList *list)
+	{
+		((T*)userData)->ts->addSclFile(sourceFile, name);
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleDefFile(void* userData, uint32_t stream, uint32_t token, const char *name, uint32_t group, OTF_KeyValueList *list)
+	{
+		((T*)userData)->ts->addFile(token, name, group);
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleDefFileGroup(void* userData, uint32_t stream, uint32_t token, const char *name, OTF_KeyValueList *list)
+	{
+		((T*)userData)->ts->addFileGroup(token, name);
+
+		return OTF_RETURN_OK;
+	}
+
 	static int handleDefAuxSamplePoint(void* userData, uint32_t stream, uint64_t time, OTF_AuxSamplePointType type, OTF_KeyValueList* list)
 	{
 		// re-implementation of this function to suppress the messages from otf_handler.h
@@ -121,226 +194,161 @@ public:
 
 	static int handleBeginProcess(void* userData, uint64_t time, uint32_t process, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "pb "
-				<< "p=" << process << " "
-				<< "t=" << ((T*)userData)->ts->getAbsoluteTime(time)*1000 << " ms"
-				<< std::endl;
-		}
+		each{0, (Modules::onBeginProcess((T*)userData, time, process), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleEndProcess(void* userData, uint64_t time, uint32_t process, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "pe "
-				<< "p=" << process << " "
-				<< "t=" << ((T*)userData)->ts->getAbsoluteTime(time)*1000 << " ms"
-				<< std::endl;
-		}
+		each{0, (Modules::onEndProcess((T*)userData, time, process), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleSendMsg(void* userData, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
+		if (batched)
 		{
-			std::cout
-				<< "sm"
-				<< " p" << sender << " --> " << length << " B --> p" << receiver << " @ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
+			auto &batch = getBatch((T*)userData, sender);
+			batch.addSend(time, receiver, length);
+			if (batch.size() >= MessageBatch::capacity)
+				flushBatch((T*)userData, sender, batch);
 		}
 
-		((T*)userData)->tviz->addSendP2P(sender, time, length);
-		((T*)userData)->tviz->addMessageCDF_P2P(sender, length);
-
-		((T*)userData)->ts->addSendMsg(sender, length, time);
+		each{0, (Modules::onSend((T*)userData, time, sender, receiver, group, type, length, source), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleRecvMsg(void* userData, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
+		if (batched)
 		{
-			std::cout
-				<< "rm"
-				<< " p" << recvProc << " <-- " << length << " B <-- p" << sendProc << " @ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
+			auto &batch = getBatch((T*)userData, recvProc);
+			batch.addRecv(time, sendProc, length);
+			if (batch.size() >= MessageBatch::capacity)
+				flushBatch((T*)userData, recvProc, batch);
 		}
 
-		((T*)userData)->tviz->addRecvP2P(recvProc, time, length);
-
-		((T*)userData)->ts->addRecvMsg(recvProc, length, time);
+		each{0, (Modules::onRecv((T*)userData, time, recvProc, sendProc, group, type, length, source), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleEnter(void* userData, uint64_t time, uint32_t function, uint32_t process, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "ef "
-				<< "p" << process << " f" << function << " "
-				<< "--> " << ((T*)userData)->ts->getFunctionName(function) << " @ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
-
-		// FIXME: broken for VampirTrace traces
-		//if (((T*)userData)->cfg->stats_fkt)
-		//	((T*)userData)->ts->addFktEnter(process, function, ((T*)userData)->ts->toNanoS(time));
+		each{0, (Modules::onEnter((T*)userData, time, function, process, source), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleLeave(void* userData, uint64_t time, uint32_t function, uint32_t process, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "lf "
-				<< "p" << process << " f" << function << " "
-				<< "<-- " << ((T*)userData)->ts->getFunctionName(function) << " @ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
-
-		// FIXME: broken for VampirTrace traces
-		//if (((T*)userData)->cfg->stats_fkt)
-		//	((T*)userData)->ts->addFktLeave(process, function, ((T*)userData)->ts->toNanoS(time));
-
-		static long x;
-		if (((T*)userData)->cfg->progress)
-		{
-			if (++x >= 500000)
-			{
-				std::cout
-					<< "Progress: "
-					<< std::fixed << std::setprecision(2) << ((T*)userData)->ts->getRelativeTime(time) * 100
-					<< " %" << '\r';
-				std::cout.flush();
-				x = 0;
-			}
-		}
+		each{0, (Modules::onLeave((T*)userData, time, function, process, source), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleCounter(void* userData, uint64_t time, uint32_t process, uint32_t counter, uint64_t value, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "ct p" << process << " c" << counter << " "
-				<< "\"" << ((T*)userData)->ts->getCounterName(counter) << "\" "
-				<< "v=" << value << " " << ((T*)userData)->ts->getCounterUnit(counter) << " "
-				<< "@ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
-
-		// PAPI
-		((T*)userData)->ts->addPapiCounter(process, counter, value);
+		each{0, (Modules::onCounter((T*)userData, time, process, counter, value), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleBeginCollectiveOperation(void* userData, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
+		if (batched)
 		{
-			std::cout
-				<< "cb "
-				<< "m" << matchingId << " "
-				<< "p" << process << " "
-				<< "root=" << rootProc << " "
-				<< "op=" << collOp << " "
-				<< "(" << ((T*)userData)->ts->getCollectiveName(collOp) << ") "
-				<< "c=" << procGroup << " "
-				<< "(" << ((T*)userData)->ts->getCommunicatorName(procGroup) << ") "
-				<< "s=" << sent << " "
-				<< "r=" << received << " "
-				<< "sclt=" << scltoken << " "
-				<< "@ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
+			auto &batch = getBatch((T*)userData, process);
+			batch.addColl(time, procGroup, collOp, sent, received);
+			if (batch.size() >= MessageBatch::capacity)
+				flushBatch((T*)userData, process, batch);
 		}
 
-		((T*)userData)->ts->addCollectiveEvent(process, procGroup, collOp, sent, received, time);
-
-		((T*)userData)->tviz->addColl(process, time, sent, received);
-		((T*)userData)->tviz->addMessageCDF_COLL(process, sent);
-
-		((T*)userData)->ts->addSendMsg(process, sent, time);
-		((T*)userData)->ts->addRecvMsg(process, received, time);
+		each{0, (Modules::onBeginCollective((T*)userData, time, process, collOp, matchingId, procGroup, rootProc, sent, received, scltoken), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleEndCollectiveOperation(void* userData, uint64_t time, uint32_t process, uint64_t matchingId, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "ce "
-				<< "m" << matchingId << " "
-				<< "p" << process << " "
-				<< "@ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
+		each{0, (Modules::onEndCollective((T*)userData, time, process, matchingId), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleRMAPut(void* userData, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "rma put "
-				<< "p" << process << " "
-				<< "o=" << origin << " "
-				<< "t=" << target << " "
-				<< "b=" << bytes << " "
-				<< "@ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
+		each{0, (Modules::onRmaPut((T*)userData, time, process, origin, target, communicator, tag, bytes, source), 0)...};
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleRMAPutRemoteEnd(void* userData, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source, OTF_KeyValueList *list)
+	{
+		each{0, (Modules::onRmaPutRemoteEnd((T*)userData, time, process, origin, target, communicator, tag, bytes, source), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleRMAGet(void* userData, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "rma get "
-				<< "p" << process << " "
-				<< "o=" << origin << " "
-				<< "t=" << target << " "
-				<< "b=" << bytes << " "
-				<< "@ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
+		each{0, (Modules::onRmaGet((T*)userData, time, process, origin, target, communicator, tag, bytes, source), 0)...};
 
 		return OTF_RETURN_OK;
 	}
 
 	static int handleRMAEnd(void* userData, uint64_t time, uint32_t process, uint32_t remote, uint32_t communicator, uint32_t tag, uint32_t source, OTF_KeyValueList *list)
 	{
-		if (((T*)userData)->cfg->rawotf)
-		{
-			std::cout
-				<< "rma end "
-				<< "p" << process << " "
-				<< "r=" << remote << " "
-				<< "@ " << ((T*)userData)->ts->getAbsoluteTime(time)
-			<< std::endl;
-		}
+		each{0, (Modules::onRmaEnd((T*)userData, time, process, remote, communicator, tag, source), 0)...};
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleFileOperation(void* userData, uint64_t time, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t operation, uint64_t bytes, uint64_t duration, uint32_t source, OTF_KeyValueList *list)
+	{
+		each{0, (Modules::onFileOperation((T*)userData, time, fileid, process, handleid, operation, bytes, duration, source), 0)...};
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleBeginFileOperation(void* userData, uint64_t time, uint32_t process, uint64_t matchingId, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		each{0, (Modules::onBeginFileOperation((T*)userData, time, process, matchingId, scltoken), 0)...};
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleEndFileOperation(void* userData, uint64_t time, uint32_t process, uint32_t fileid, uint64_t matchingId, uint64_t handleId, uint32_t operation, uint64_t bytes, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		each{0, (Modules::onEndFileOperation((T*)userData, time, process, fileid, matchingId, handleId, operation, bytes, scltoken), 0)...};
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleFunctionSummary(void* userData, uint64_t time, uint32_t function, uint32_t process, uint64_t invocations, uint64_t exclTime, uint64_t inclTime, OTF_KeyValueList *list)
+	{
+		// summaries repeat what the events tell, only use them if no events are read
+		if (((T*)userData)->cfg->summary_only)
+			((T*)userData)->ts->addFunctionSummary(process, function, time, invocations, exclTime, inclTime);
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleMessageSummary(void* userData, uint64_t time, uint32_t process, uint32_t peer, uint32_t comm, uint32_t type, uint64_t sentNumber, uint64_t receivedNumber, uint64_t sentBytes, uint64_t receivedBytes, OTF_KeyValueList *list)
+	{
+		if (((T*)userData)->cfg->summary_only)
+			((T*)userData)->ts->addMessageSummary(process, peer, comm, type, time, sentNumber, receivedNumber, sentBytes, receivedBytes);
+
+		return OTF_RETURN_OK;
+	}
+
+	static int handleCollopSummary(void *userData, uint64_t time, uint32_t process, uint32_t comm, uint32_t collective, uint64_t sentNumber, uint64_t receivedNumber, uint64_t sentBytes, uint64_t receivedBytes, OTF_KeyValueList *list)
+	{
+		if (((T*)userData)->cfg->summary_only)
+			((T*)userData)->ts->addCollopSummary(process, comm, collective, time, sentNumber, receivedNumber, sentBytes, receivedBytes);
 
 		return OTF_RETURN_OK;
 	}
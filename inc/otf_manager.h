@@ -2,9 +2,20 @@
 #define OTF_MANAGER_H_
 
 #include <map>
+#include <set>
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <string>
 #include <limits>
 #include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cassert>
 
 #include <otf.h>
 
@@ -14,6 +25,15 @@
 #include <otf_handler_sonar.h>
 #include <trace_stats.h>
 #include <trace_visualizer.h>
+#include <event_cache.h>
+#include <event_record.h>
+#include <spsc_ring.h>
+#include <message_batch.h>
+#include <token_map.h>
+#include <activity_tracker.h>
+#include <message_matcher.h>
+#include <collective_tracker.h>
+#include <file_op_tracker.h>
 
 //RAII Class
 class OTF_Manager {
@@ -23,12 +43,64 @@ class OTF_Manager {
 		OTF_Reader       *reader        {nullptr};
 		OTF_HandlerArray *handler_array {nullptr};
 
+		uint32_t num_files   {100};
+		uint32_t buffer_size {4*1024};
+
 		struct UserData {
 			std::shared_ptr<Config>          cfg  {};
 			std::shared_ptr<TraceStats>      ts   {};
 			std::shared_ptr<TraceVisualizer> tviz {};
+			std::shared_ptr<EventCache> cache {}; // written by the EventRecorder module while set
+			TokenMap<MessageBatch> batches {}; // message events not yet handed over
+			uint32_t      batch_proc {TokenIndex::npos}; // process of the last message event
+			MessageBatch *batch      {nullptr};          // and its batch
+			std::shared_ptr<ActivityTracker> activity {}; // gaps between the message events
+			std::shared_ptr<MessageMatcher>  matcher  {}; // pairs sends with receives
+			std::shared_ptr<CollectiveTracker> colls  {}; // collective instances in progress
+			std::shared_ptr<FileOpTracker>     files  {}; // file operations in progress
 		} udata {};
 
+		// entry points of one Sonar instantiation, see select_handlers()
+		struct Handlers {
+			uint32_t features;
+			void     (*set)(OTF_HandlerArray *handlers, UserData *data);
+			uint64_t (*replay)(const std::string &filename, UserData *data);
+			void     (*dispatch)(UserData *data, const EventRecord *events, size_t n);
+			void     (*flush)(UserData *data);
+		};
+		const Handlers *sonar {nullptr};
+
+		template<typename S> static Handlers make_handlers(void);
+		template<typename... M> static void add_handlers(std::vector<Handlers> &table);
+		static const Handlers& select_handlers(uint32_t needed);
+		void use_handlers(uint32_t features);
+
+		std::map<uint32_t, uint64_t> cached_procs {};
+		bool cache_ok {true};
+
+		bool     events_need_order(void);
+		bool     slices_split_analysis(void);
+		uint64_t read_events_parallel(void);
+		uint64_t read_events_sliced(void);
+		uint64_t read_events_cached(const std::string &dir);
+		uint64_t read_events_pipelined(bool unsorted);
+		void     close_cache(UserData &data);
+
+		std::vector<uint64_t> slice_boundaries(uint32_t nslices);
+		/*
+		 * Shards are the UserData of the workers of a parallel run. Every
+		 * analysis has a merge(other): for the processes both instances have
+		 * seen, other holds the events following ours (the next time slice);
+		 * stream shards have disjoint processes. The TraceStats of a shard
+		 * are merged before its trackers, so the matches completed by the
+		 * merge find the calls of the shard.
+		 */
+		std::vector<UserData> make_shards(size_t n);
+		static void track_activity(UserData &data, bool shard);
+		static void match_messages(UserData &data, bool shard);
+		static void track_collectives(UserData &data);
+		static void track_file_ops(UserData &data);
+
 	public:
 		OTF_Manager(const OTF_Manager&);
 		OTF_Manager(std::shared_ptr<Config> _cfg, uint32_t nfiles=100, uint32_t buffersize=4*1024);
@@ -37,7 +109,7 @@ class OTF_Manager {
 		OTF_Manager& operator=(const OTF_Manager& q);
 
 		void read_otf(void);
-		template<typename T> void set_handler_Functions(void);
+		template<typename T> static void set_handler_Functions(OTF_HandlerArray *handlers, UserData *data);
 };
 
 #endif
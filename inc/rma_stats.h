@@ -0,0 +1,67 @@
+#ifndef _RMA_STATS_H_
+#define _RMA_STATS_H_
+
+#include <iostream>
+#include <memory>
+#include <limits>
+#include <cstdint>
+
+#include <globals.h>
+#include <token_map.h>
+#include <size_histogram.h>
+#include <comm_matrix.h>
+
+/*
+ * Accumulates one-sided (RMA) communication: operations and bytes of every
+ * process as origin and as target, an origin x target matrix of puts and one
+ * of gets, and the sizes of all puts and gets. Everything is a sum, so the
+ * instances of a parallel run merge in any order.
+ */
+class RmaStats {
+public:
+	struct Transfer {
+		uint64_t ops   {0};
+		uint64_t bytes {0};
+		uint64_t min   {std::numeric_limits<uint64_t>::max()};
+		uint64_t max   {0};
+		SizeHistogram sizes {};
+
+		void add(uint64_t length, bool exact);
+		void merge(const Transfer &other);
+	};
+
+	struct Process {
+		Transfer put    {}; // issued as origin
+		Transfer get    {};
+		Transfer put_in {}; // targeted by others
+		Transfer get_in {};
+		uint64_t ends   {0}; // completed operations
+	};
+
+private:
+	bool exact {false};
+	TokenMap<Process> procs {};
+	CommMatrix put_matrix {}; // origin x target
+	CommMatrix get_matrix {};
+	Transfer puts {};
+	Transfer gets {};
+
+public:
+	RmaStats() {}
+	RmaStats(std::shared_ptr<const TokenIndex> index, bool exact_sizes);
+
+	void addPut(uint32_t origin, uint32_t target, uint64_t bytes);
+	void addGet(uint32_t origin, uint32_t target, uint64_t bytes);
+	void addEnd(uint32_t proc);
+
+	void merge(const RmaStats &other);
+	bool empty(void) const { return puts.ops == 0 && gets.ops == 0 && procs.empty(); }
+
+	const TokenMap<Process>& processes(void) const { return procs; }
+	const Transfer& totalPuts(void) const { return puts; }
+	const Transfer& totalGets(void) const { return gets; }
+	CommMatrix& putMatrix(void) { return put_matrix; }
+	CommMatrix& getMatrix(void) { return get_matrix; }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef _SIZE_HISTOGRAM_H_
+#define _SIZE_HISTOGRAM_H_
+
+#include <map>
+#include <cstdint>
+
+#include <log_histogram.h>
+
+/*
+ * Histogram of message sizes. By default the sizes are counted in the log
+ * buckets of a LogHistogram (constant cost per message, at most ~3% wide),
+ * in exact mode every distinct size is counted on its own.
+ * The mode is fixed on construction; containers holding default constructed
+ * histograms assign SizeHistogram(exact) before the first add().
+ */
+class SizeHistogram {
+private:
+	bool exact {false};
+	LogHistogram hist {};
+	std::map<uint64_t, uint64_t> sizes {};
+
+public:
+	SizeHistogram() {}
+	explicit SizeHistogram(bool exact_sizes) : exact(exact_sizes) {}
+
+	void add(uint64_t size, uint64_t n=1)
+	{
+		if (exact)
+			sizes[size] += n;
+		else
+			hist.add(size, n);
+	}
+
+	void merge(const SizeHistogram &other)
+	{
+		if (empty())
+		{
+			*this = other;
+			return;
+		}
+
+		if (other.exact)
+			for (const auto &s:other.sizes)
+				add(s.first, s.second);
+		else
+			hist.merge(other.hist);
+	}
+
+	uint64_t count(void) const
+	{
+		if (!exact)
+			return hist.count();
+
+		uint64_t total = 0;
+		for (const auto &s:sizes)
+			total += s.second;
+		return total;
+	}
+
+	bool empty(void) const { return exact ? sizes.empty() : hist.empty(); }
+	bool isExact(void) const { return exact; }
+
+	// calls f(lower, upper, count) for all sizes/buckets in ascending order
+	template<typename F>
+	void forEach(F f) const
+	{
+		if (exact)
+			for (const auto &s:sizes)
+				f(s.first, s.first, s.second);
+		else
+			hist.forEach(f);
+	}
+};
+
+#endif
@@ -0,0 +1,624 @@
+#ifndef _SONAR_MODULES_H_
+#define _SONAR_MODULES_H_
+
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+
+#include <globals.h>
+#include <config.h>
+#include <message_batch.h>
+#include <token_map.h>
+
+/*
+ * Analysis modules of the Sonar handler. Sonar<T, Modules...> decodes a
+ * record once and passes it to the hooks of its modules; the hooks of
+ * SonarModule do nothing, a module only hides those it needs. Modules left
+ * out of a Sonar instantiation produce no code in its handlers. The hooks
+ * run in the order of the modules and do not look at the options, those
+ * choose the instantiation (OTF_Manager::select_handlers()).
+ *
+ * T is the user data of the handlers (OTF_Manager::UserData).
+ */
+
+// analyses of the modules, a Sonar instantiation covers those of its modules
+enum SonarFeature : uint32_t {
+	SONAR_FUNCTIONS   = 1 << 0,
+	SONAR_MESSAGES    = 1 << 1,
+	SONAR_MATCHING    = 1 << 2,
+	SONAR_COLLECTIVES = 1 << 3,
+	SONAR_PLOTS       = 1 << 4,
+	SONAR_CCT         = 1 << 5,
+	SONAR_WAIT_STATES = 1 << 6,
+	SONAR_COMM_MATRIX = 1 << 7,
+	SONAR_CALL_SITES  = 1 << 8,
+	SONAR_RMA         = 1 << 9,
+	SONAR_FILE_IO     = 1 << 10,
+	SONAR_RAWOTF      = 1 << 11,
+	SONAR_PROGRESS    = 1 << 12,
+	SONAR_CACHE       = 1 << 13,
+};
+
+// modules a run must not get unasked: they print, write or keep data until the end
+const uint32_t SONAR_EXACT = SONAR_WAIT_STATES | SONAR_RAWOTF | SONAR_PROGRESS | SONAR_CACHE;
+
+// modules taking the message batches, without them the handlers collect none
+const uint32_t SONAR_BATCHED = SONAR_MESSAGES | SONAR_PLOTS | SONAR_COMM_MATRIX;
+
+// features a run with this configuration needs, SONAR_CACHE is added while the cache is written
+inline uint32_t sonar_features(const Config &cfg)
+{
+	uint32_t f = 0;
+	if (cfg.functions)
+		f |= SONAR_FUNCTIONS;
+	if (cfg.messages)
+		f |= SONAR_MESSAGES | SONAR_MATCHING;
+	if (cfg.collectives)
+		f |= SONAR_COLLECTIVES;
+	if (cfg.plots)
+		f |= SONAR_PLOTS;
+	if (cfg.cct)
+		f |= SONAR_CCT;
+	if (cfg.wait_states)
+		f |= SONAR_WAIT_STATES;
+	if (cfg.comm_matrix)
+		f |= SONAR_COMM_MATRIX;
+	if (cfg.call_sites > 0)
+		f |= SONAR_CALL_SITES;
+	if (cfg.rma)
+		f |= SONAR_RMA;
+	if (cfg.file_io)
+		f |= SONAR_FILE_IO;
+	if (cfg.rawotf)
+		f |= SONAR_RAWOTF;
+	if (cfg.progress)
+		f |= SONAR_PROGRESS;
+	return f;
+}
+
+// union of the features of a list of modules
+template <typename... M>
+struct SonarFeatures {
+	static constexpr uint32_t value(void) { return 0; }
+};
+template <typename M, typename... Tail>
+struct SonarFeatures<M, Tail...> {
+	static constexpr uint32_t value(void) { return M::features() | SonarFeatures<Tail...>::value(); }
+};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+struct SonarModule {
+	static constexpr uint32_t features(void) { return 0; }
+
+	template <typename T> static void onBeginProcess(T *data, uint64_t time, uint32_t process) {}
+	template <typename T> static void onEndProcess(T *data, uint64_t time, uint32_t process) {}
+	template <typename T> static void onEnter(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source) {}
+	template <typename T> static void onLeave(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source) {}
+	template <typename T> static void onSend(T *data, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source) {}
+	template <typename T> static void onRecv(T *data, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source) {}
+	template <typename T> static void onMessageBatch(T *data, uint32_t proc, const MessageBatch &batch) {}
+	template <typename T> static void onCounter(T *data, uint64_t time, uint32_t process, uint32_t counter, uint64_t value) {}
+	template <typename T> static void onBeginCollective(T *data, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken) {}
+	template <typename T> static void onEndCollective(T *data, uint64_t time, uint32_t process, uint64_t matchingId) {}
+	template <typename T> static void onRmaPut(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source) {}
+	template <typename T> static void onRmaPutRemoteEnd(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source) {}
+	template <typename T> static void onRmaGet(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source) {}
+	template <typename T> static void onRmaEnd(T *data, uint64_t time, uint32_t process, uint32_t remote, uint32_t comm, uint32_t tag, uint32_t source) {}
+	template <typename T> static void onFileOperation(T *data, uint64_t time, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t operation, uint64_t bytes, uint64_t duration, uint32_t source) {}
+	template <typename T> static void onBeginFileOperation(T *data, uint64_t time, uint32_t process, uint64_t matchingId, uint32_t scltoken) {}
+	template <typename T> static void onEndFileOperation(T *data, uint64_t time, uint32_t process, uint32_t fileid, uint64_t matchingId, uint64_t handleId, uint32_t operation, uint64_t bytes, uint32_t scltoken) {}
+};
+
+// function statistics, call stacks and PAPI counters
+struct FunctionStats : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_FUNCTIONS; }
+
+	template <typename T>
+	static void onEnter(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->ts->addFktEnter(process, function, data->ts->toNanoS(time));
+	}
+
+	template <typename T>
+	static void onLeave(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->ts->addFktLeave(process, function, data->ts->toNanoS(time));
+	}
+
+	// the rate plots of TraceViz take the slot found here
+	template <typename T>
+	static void onCounter(T *data, uint64_t time, uint32_t process, uint32_t counter, uint64_t value)
+	{
+		const uint32_t slot = data->ts->addPapiCounter(process, counter, value);
+		if (slot != TokenIndex::npos)
+			data->tviz->addCounterSample(process, slot, time, value);
+	}
+};
+
+// calling-context trees (--cct), after FunctionStats: places the call it entered in the tree
+struct Cct : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_CCT; }
+
+	template <typename T>
+	static void onEnter(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->ts->addCctEnter(process);
+	}
+};
+
+// message sizes and idle times
+struct MsgStats : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_MESSAGES; }
+
+	template <typename T>
+	static void onMessageBatch(T *data, uint32_t proc, const MessageBatch &batch)
+	{
+		data->ts->addMessageBatch(proc, batch);
+		data->activity->addMessageBatch(proc, batch);
+	}
+};
+
+// pairs sends with receives: latencies and bandwidths
+struct MsgMatch : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_MATCHING; }
+
+	template <typename T>
+	static void onSend(T *data, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->matcher->addSend(time, sender, receiver, group, type, length, 0);
+	}
+
+	template <typename T>
+	static void onRecv(T *data, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->matcher->addRecv(time, recvProc, sendProc, group, type, length, 0);
+	}
+};
+
+/*
+ * Late senders and receivers (--wait-states): matches the messages like
+ * MsgMatch, which it replaces, along with the calls they were sent or
+ * received in. Comes before FunctionStats, the calls a leave closes are
+ * looked at before they are gone.
+ */
+struct WaitStates : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_MATCHING | SONAR_WAIT_STATES; }
+
+	template <typename T>
+	static void onSend(T *data, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->matcher->addSend(time, sender, receiver, group, type, length, data->ts->messageRegion(sender, data->ts->toNanoS(time), true));
+	}
+
+	template <typename T>
+	static void onRecv(T *data, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->matcher->addRecv(time, recvProc, sendProc, group, type, length, data->ts->messageRegion(recvProc, data->ts->toNanoS(time), false));
+	}
+
+	template <typename T>
+	static void onLeave(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->ts->addSendRegionLeave(process, function, data->ts->toNanoS(time));
+	}
+};
+
+// collective instances
+struct CollStats : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_COLLECTIVES; }
+
+	template <typename T>
+	static void onBeginCollective(T *data, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken)
+	{
+		data->colls->addBegin(process, time, matchingId, procGroup, collOp, data->ts->getCommunicatorSize(procGroup));
+	}
+
+	template <typename T>
+	static void onEndCollective(T *data, uint64_t time, uint32_t process, uint64_t matchingId)
+	{
+		data->colls->addEnd(process, time, matchingId);
+	}
+};
+
+// injection and CDF plots, the counter plots get their samples from FunctionStats
+struct TraceViz : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_PLOTS; }
+
+	template <typename T>
+	static void onMessageBatch(T *data, uint32_t proc, const MessageBatch &batch)
+	{
+		data->tviz->addMessageBatch(proc, batch);
+	}
+};
+
+// process-to-process bytes and messages (--comm-matrix)
+struct MatrixStats : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_COMM_MATRIX; }
+
+	template <typename T>
+	static void onMessageBatch(T *data, uint32_t proc, const MessageBatch &batch)
+	{
+		data->ts->addMatrixBatch(proc, batch);
+	}
+};
+
+// messages and collectives per source code location (--call-sites)
+struct CallSites : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_CALL_SITES; }
+
+	template <typename T>
+	static void onEnter(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->ts->addSiteCall(source);
+	}
+
+	template <typename T>
+	static void onSend(T *data, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->ts->addSiteSend(source, length);
+	}
+
+	template <typename T>
+	static void onRecv(T *data, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->ts->addSiteRecv(source, length);
+	}
+
+	template <typename T>
+	static void onBeginCollective(T *data, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken)
+	{
+		data->ts->addSiteCollective(scltoken, sent, received);
+	}
+};
+
+// one-sided communication (--rma)
+struct RmaComm : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_RMA; }
+
+	template <typename T>
+	static void onRmaPut(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		data->ts->addRmaPut(origin, target, bytes);
+	}
+
+	template <typename T>
+	static void onRmaPutRemoteEnd(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		data->ts->addRmaPut(origin, target, bytes);
+	}
+
+	template <typename T>
+	static void onRmaGet(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		data->ts->addRmaGet(origin, target, bytes);
+	}
+
+	template <typename T>
+	static void onRmaEnd(T *data, uint64_t time, uint32_t process, uint32_t remote, uint32_t comm, uint32_t tag, uint32_t source)
+	{
+		data->ts->addRmaEnd(process);
+	}
+};
+
+// file I/O (--file-io)
+struct FileIo : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_FILE_IO; }
+
+	template <typename T>
+	static void onFileOperation(T *data, uint64_t time, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t operation, uint64_t bytes, uint64_t duration, uint32_t source)
+	{
+		data->files->addOperation(process, time, time + duration, fileid, operation, bytes);
+	}
+
+	template <typename T>
+	static void onBeginFileOperation(T *data, uint64_t time, uint32_t process, uint64_t matchingId, uint32_t scltoken)
+	{
+		data->files->addBegin(process, time, matchingId);
+	}
+
+	template <typename T>
+	static void onEndFileOperation(T *data, uint64_t time, uint32_t process, uint32_t fileid, uint64_t matchingId, uint64_t handleId, uint32_t operation, uint64_t bytes, uint32_t scltoken)
+	{
+		data->files->addEnd(process, time, matchingId, fileid, operation, bytes);
+	}
+};
+
+// progress of the reading (--progress), from the leaves of the calls
+struct Progress : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_PROGRESS; }
+
+	template <typename T>
+	static void onLeave(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		static thread_local long x;
+		if (++x >= 500000)
+		{
+			std::cout
+				<< "Progress: "
+				<< std::fixed << std::setprecision(2) << data->ts->getRelativeTime(time) * 100
+				<< " %" << '\r';
+			std::cout.flush();
+			x = 0;
+		}
+	}
+};
+
+// records the events into the event cache (--cache), only selected while it is written
+struct EventRecorder : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_CACHE; }
+
+	template <typename T>
+	static void onEnter(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->cache->addEnter(process, time, function, source);
+	}
+
+	template <typename T>
+	static void onLeave(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		data->cache->addLeave(process, time, function, source);
+	}
+
+	template <typename T>
+	static void onSend(T *data, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->cache->addSend(sender, time, receiver, group, type, length, source);
+	}
+
+	template <typename T>
+	static void onRecv(T *data, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		data->cache->addRecv(recvProc, time, sendProc, group, type, length, source);
+	}
+
+	template <typename T>
+	static void onCounter(T *data, uint64_t time, uint32_t process, uint32_t counter, uint64_t value)
+	{
+		data->cache->addCounter(process, time, counter, value);
+	}
+
+	template <typename T>
+	static void onBeginCollective(T *data, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken)
+	{
+		data->cache->addBeginCollop(process, time, collOp, matchingId, procGroup, rootProc, sent, received, scltoken);
+	}
+
+	template <typename T>
+	static void onEndCollective(T *data, uint64_t time, uint32_t process, uint64_t matchingId)
+	{
+		data->cache->addEndCollop(process, time, matchingId);
+	}
+
+	template <typename T>
+	static void onRmaPut(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		data->cache->addRmaPut(process, time, origin, target, comm, tag, bytes, source);
+	}
+
+	template <typename T>
+	static void onRmaPutRemoteEnd(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		data->cache->addRmaPutRemoteEnd(process, time, origin, target, comm, tag, bytes, source);
+	}
+
+	template <typename T>
+	static void onRmaGet(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		data->cache->addRmaGet(process, time, origin, target, comm, tag, bytes, source);
+	}
+
+	template <typename T>
+	static void onRmaEnd(T *data, uint64_t time, uint32_t process, uint32_t remote, uint32_t comm, uint32_t tag, uint32_t source)
+	{
+		data->cache->addRmaEnd(process, time, remote, comm, tag, source);
+	}
+
+	template <typename T>
+	static void onFileOperation(T *data, uint64_t time, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t operation, uint64_t bytes, uint64_t duration, uint32_t source)
+	{
+		data->cache->addFileOp(process, time, fileid, handleid, operation, bytes, duration, source);
+	}
+
+	template <typename T>
+	static void onBeginFileOperation(T *data, uint64_t time, uint32_t process, uint64_t matchingId, uint32_t scltoken)
+	{
+		data->cache->addBeginFileOp(process, time, matchingId, scltoken);
+	}
+
+	template <typename T>
+	static void onEndFileOperation(T *data, uint64_t time, uint32_t process, uint32_t fileid, uint64_t matchingId, uint64_t handleId, uint32_t operation, uint64_t bytes, uint32_t scltoken)
+	{
+		data->cache->addEndFileOp(process, time, fileid, matchingId, handleId, operation, bytes, scltoken);
+	}
+};
+
+// prints the event records (--rawotf), only part of the handlers selected for it
+struct RawOtf : SonarModule {
+	static constexpr uint32_t features(void) { return SONAR_RAWOTF; }
+
+	template <typename T>
+	static void onBeginProcess(T *data, uint64_t time, uint32_t process)
+	{
+		std::cout
+			<< "pb "
+			<< "p=" << process << " "
+			<< "t=" << data->ts->getAbsoluteTime(time)*1000 << " ms"
+			<< std::endl;
+	}
+
+	template <typename T>
+	static void onEndProcess(T *data, uint64_t time, uint32_t process)
+	{
+		std::cout
+			<< "pe "
+			<< "p=" << process << " "
+			<< "t=" << data->ts->getAbsoluteTime(time)*1000 << " ms"
+			<< std::endl;
+	}
+
+	template <typename T>
+	static void onSend(T *data, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		std::cout
+			<< "sm"
+			<< " p" << sender << " --> " << length << " B --> p" << receiver << " @ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onRecv(T *data, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+	{
+		std::cout
+			<< "rm"
+			<< " p" << recvProc << " <-- " << length << " B <-- p" << sendProc << " @ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onEnter(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		std::cout
+			<< "ef "
+			<< "p" << process << " f" << function << " "
+			<< "--> " << data->ts->getFunctionName(function) << " @ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onLeave(T *data, uint64_t time, uint32_t function, uint32_t process, uint32_t source)
+	{
+		std::cout
+			<< "lf "
+			<< "p" << process << " f" << function << " "
+			<< "<-- " << data->ts->getFunctionName(function) << " @ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onCounter(T *data, uint64_t time, uint32_t process, uint32_t counter, uint64_t value)
+	{
+		std::cout
+			<< "ct p" << process << " c" << counter << " "
+			<< "\"" << data->ts->getCounterName(counter) << "\" "
+			<< "v=" << value << " " << data->ts->getCounterUnit(counter) << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onBeginCollective(T *data, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken)
+	{
+		std::cout
+			<< "cb "
+			<< "m" << matchingId << " "
+			<< "p" << process << " "
+			<< "root=" << rootProc << " "
+			<< "op=" << collOp << " "
+			<< "(" << data->ts->getCollectiveName(collOp) << ") "
+			<< "c=" << procGroup << " "
+			<< "(" << data->ts->getCommunicatorName(procGroup) << ") "
+			<< "s=" << sent << " "
+			<< "r=" << received << " "
+			<< "sclt=" << scltoken << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onEndCollective(T *data, uint64_t time, uint32_t process, uint64_t matchingId)
+	{
+		std::cout
+			<< "ce "
+			<< "m" << matchingId << " "
+			<< "p" << process << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void printRma(T *data, const char *what, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint64_t bytes)
+	{
+		std::cout
+			<< "rma " << what << " "
+			<< "p" << process << " "
+			<< "o=" << origin << " "
+			<< "t=" << target << " "
+			<< "b=" << bytes << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onRmaPut(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		printRma(data, "put", time, process, origin, target, bytes);
+	}
+
+	template <typename T>
+	static void onRmaPutRemoteEnd(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		printRma(data, "putre", time, process, origin, target, bytes);
+	}
+
+	template <typename T>
+	static void onRmaGet(T *data, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		printRma(data, "get", time, process, origin, target, bytes);
+	}
+
+	template <typename T>
+	static void onRmaEnd(T *data, uint64_t time, uint32_t process, uint32_t remote, uint32_t comm, uint32_t tag, uint32_t source)
+	{
+		std::cout
+			<< "rma end "
+			<< "p" << process << " "
+			<< "r=" << remote << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onFileOperation(T *data, uint64_t time, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t operation, uint64_t bytes, uint64_t duration, uint32_t source)
+	{
+		std::cout
+			<< "fo "
+			<< "p" << process << " "
+			<< "f=" << fileid << " "
+			<< "op=" << operation << " "
+			<< "b=" << bytes << " "
+			<< "d=" << duration << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onBeginFileOperation(T *data, uint64_t time, uint32_t process, uint64_t matchingId, uint32_t scltoken)
+	{
+		std::cout
+			<< "fb "
+			<< "m" << matchingId << " "
+			<< "p" << process << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+
+	template <typename T>
+	static void onEndFileOperation(T *data, uint64_t time, uint32_t process, uint32_t fileid, uint64_t matchingId, uint64_t handleId, uint32_t operation, uint64_t bytes, uint32_t scltoken)
+	{
+		std::cout
+			<< "fe "
+			<< "m" << matchingId << " "
+			<< "p" << process << " "
+			<< "f=" << fileid << " "
+			<< "op=" << operation << " "
+			<< "b=" << bytes << " "
+			<< "@ " << data->ts->getAbsoluteTime(time)
+		<< std::endl;
+	}
+};
+
+#pragma GCC diagnostic pop
+
+#endif
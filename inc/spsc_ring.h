@@ -0,0 +1,64 @@
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+/*
+ * Bounded lock-free ring buffer for exactly one producer and one consumer
+ * thread. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscRing {
+private:
+	std::vector<T> slots;
+	size_t         mask;
+
+	// written by one side each, kept on separate cache lines
+	alignas(64) std::atomic<size_t> head {0}; // next slot to pop
+	alignas(64) std::atomic<size_t> tail {0}; // next slot to push
+
+	static size_t round_up(size_t n)
+	{
+		size_t cap = 1;
+		while (cap < n)
+			cap <<= 1;
+		return cap;
+	}
+
+public:
+	SpscRing(size_t capacity) :
+		slots(round_up(capacity)),
+		mask(round_up(capacity) - 1)
+	{}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	// producer side, false if the ring is full
+	bool push(const T &item)
+	{
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) > mask)
+			return false;
+
+		slots[t & mask] = item;
+		tail.store(t+1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, false if the ring is empty
+	bool pop(T &item)
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+
+		item = slots[h & mask];
+		head.store(h+1, std::memory_order_release);
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef _TOKEN_MAP_H_
+#define _TOKEN_MAP_H_
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+
+/*
+ * Maps the OTF tokens of one kind (processes, functions, ...) to dense
+ * indices 0..n-1. It is filled while reading the definitions and only read
+ * afterwards, so it can be shared by the shards of a parallel run.
+ * Tokens are looked up in a flat table; tokens far beyond the number of
+ * defined ones (sparse token ranges) are kept in a hash map instead.
+ */
+class TokenIndex {
+private:
+	enum : uint32_t { direct_limit = 1u << 20 };
+
+	std::vector<uint32_t> direct {};  // token -> index+1, 0 if not defined
+	std::unordered_map<uint32_t, uint32_t> sparse {};
+	std::vector<uint32_t> tokens {};  // index -> token
+
+public:
+	enum : uint32_t { npos = std::numeric_limits<uint32_t>::max() };
+
+	uint32_t add(uint32_t token)
+	{
+		const uint32_t found = find(token);
+		if (found != npos)
+			return found;
+
+		const uint32_t index = tokens.size();
+		tokens.push_back(token);
+
+		// keep the table at most a few times larger than the number of tokens
+		if (token < direct_limit && token < 64 * tokens.size() + 4096)
+		{
+			if (token >= direct.size())
+				direct.resize(token+1, 0);
+			direct[token] = index+1;
+		}
+		else
+		{
+			sparse[token] = index;
+		}
+
+		return index;
+	}
+
+	uint32_t find(uint32_t token) const
+	{
+		if (token < direct.size() && direct[token] != 0)
+			return direct[token]-1;
+
+		if (sparse.empty())
+			return npos;
+
+		auto it = sparse.find(token);
+		return it != sparse.end() ? it->second : npos;
+	}
+
+	uint32_t token(uint32_t index) const { return tokens[index]; }
+	size_t   size(void) const            { return tokens.size(); }
+};
+
+/*
+ * Drop-in replacement of std::map<uint32_t, V> for token-keyed data.
+ * Values of tokens in the index are stored in a flat vector at their dense
+ * index, others in a std::map. Iteration visits the entries in token order
+ * like std::map; entries must not be added while iterating.
+ *
+ * The token order is kept in a list of the entries that is only rebuilt
+ * after entries were added. Even a const iteration may rebuild it, so a
+ * map must not be iterated by several threads at the same time.
+ *
+ * Unlike std::map, operator[] of a token without entry may move all
+ * values of the vector: references and pointers to values are invalid
+ * after an entry was added.
+ */
+template<typename V>
+class TokenMap {
+public:
+	using value_type = std::pair<const uint32_t, V>;
+
+private:
+	std::shared_ptr<const TokenIndex> index {};
+	std::vector<value_type> dense {};
+	std::vector<uint8_t>    used  {};
+	size_t                  nused {0};
+	std::map<uint32_t, V>   other {};
+
+	// entries in token order, points into dense and other
+	mutable std::vector<value_type*> order {};
+	mutable bool                     stale {false};
+
+	template<typename E>
+	class Iterator {
+	private:
+		value_type* const *entry;
+	public:
+		explicit Iterator(value_type* const *e) : entry(e) {}
+
+		E& operator*(void) const  { return **entry; }
+		E* operator->(void) const { return *entry; }
+		Iterator& operator++(void) { ++entry; return *this; }
+		bool operator==(const Iterator &it) const { return entry == it.entry; }
+		bool operator!=(const Iterator &it) const { return entry != it.entry; }
+	};
+
+	void sort(void) const
+	{
+		if (!stale)
+			return;
+
+		auto &self = const_cast<TokenMap&>(*this);
+		order.clear();
+		order.reserve(size());
+		for (size_t i=0; i<dense.size(); i++)
+			if (used[i])
+				order.push_back(&self.dense[i]);
+		for (auto &o:self.other)
+			order.push_back(&o);
+
+		std::sort(order.begin(), order.end(), [](const value_type *a, const value_type *b) { return a->first < b->first; });
+		stale = false;
+	}
+
+public:
+	using iterator       = Iterator<value_type>;
+	using const_iterator = Iterator<const value_type>;
+
+	TokenMap() {}
+	explicit TokenMap(std::shared_ptr<const TokenIndex> idx) : index(idx) {}
+
+	// the order points into the copied map, a copy sorts its own
+	TokenMap(const TokenMap &m) : index(m.index), dense(m.dense), used(m.used), nused(m.nused), other(m.other), stale(true) {}
+	TokenMap(TokenMap &&m) = default;
+	TokenMap& operator=(const TokenMap &m)
+	{
+		// the pairs of dense can not be assigned, only constructed
+		if (this != &m)
+			*this = TokenMap(m);
+		return *this;
+	}
+	TokenMap& operator=(TokenMap &&m) = default;
+
+	V& operator[](uint32_t token)
+	{
+		const uint32_t i = index ? index->find(token) : TokenIndex::npos;
+		if (i == TokenIndex::npos)
+		{
+			auto it = other.lower_bound(token);
+			if (it == other.end() || it->first != token)
+			{
+				it = other.emplace_hint(it, std::piecewise_construct, std::forward_as_tuple(token), std::forward_as_tuple());
+				stale = true;
+			}
+			return it->second;
+		}
+
+		while (dense.size() <= i)
+		{
+			dense.emplace_back(std::piecewise_construct, std::forward_as_tuple(index->token(dense.size())), std::forward_as_tuple());
+			used.push_back(0);
+		}
+
+		if (!used[i])
+		{
+			used[i] = 1;
+			nused++;
+			stale = true;
+		}
+
+		return dense[i].second;
+	}
+
+	size_t size(void) const  { return nused + other.size(); }
+	bool   empty(void) const { return size() == 0; }
+
+	size_t count(uint32_t token) const
+	{
+		const uint32_t i = index ? index->find(token) : TokenIndex::npos;
+		if (i == TokenIndex::npos)
+			return other.count(token);
+		return i < used.size() && used[i];
+	}
+
+	void clear(void)
+	{
+		dense.clear();
+		used.clear();
+		nused = 0;
+		other.clear();
+		order.clear();
+		stale = false;
+	}
+
+	iterator begin(void)             { sort(); return iterator(order.data()); }
+	iterator end(void)               { sort(); return iterator(order.data() + order.size()); }
+	const_iterator begin(void) const { sort(); return const_iterator(order.data()); }
+	const_iterator end(void) const   { sort(); return const_iterator(order.data() + order.size()); }
+};
+
+#endif
@@ -8,19 +8,42 @@
 #include <atomic>
 #include <set>
 #include <map>
+#include <tuple>
 #include <vector>
 #include <memory>
 #include <numeric>
 #include <limits>
+#include <cmath>
+#include <algorithm>
+#include <functional>
 
 #include <globals.h>
 #include <config.h>
+#include <message_batch.h>
+#include <activity_tracker.h>
+#include <message_matcher.h>
+#include <collective_tracker.h>
+#include <comm_matrix.h>
+#include <rma_stats.h>
+#include <file_op_tracker.h>
+#include <token_map.h>
+#include <log_histogram.h>
+#include <size_histogram.h>
+#include <call_tree.h>
 
 class TraceStats {
 private:
 
 	std::shared_ptr<Config> config;
 
+	// dense indices of the tokens, built from the definitions
+	std::shared_ptr<TokenIndex> proc_index    {std::make_shared<TokenIndex>()};
+	std::shared_ptr<TokenIndex> func_index    {std::make_shared<TokenIndex>()};
+	std::shared_ptr<TokenIndex> counter_index {std::make_shared<TokenIndex>()};
+	std::shared_ptr<TokenIndex> comm_index    {std::make_shared<TokenIndex>()};
+	std::shared_ptr<TokenIndex> scl_index     {std::make_shared<TokenIndex>()};
+	std::shared_ptr<TokenIndex> file_index    {std::make_shared<TokenIndex>()};
+
 	// OTF Trace specific parameters
 	struct OTF_Trace_Param {
 		std::string creator      {};
@@ -34,7 +57,7 @@ private:
 		std::string name   {};
 		uint32_t    parent {};
 	};
-	std::map<uint32_t, ProcessParameters> process_map {};
+	TokenMap<ProcessParameters> process_map {proc_index};
 
 	// Proc Group Defs
 	struct ProcessGroupParameters {
@@ -51,7 +74,7 @@ private:
 		uint32_t    source {};
 	};
 	std::map<uint32_t, std::string> function_group_map {};
-	std::map<uint32_t, FunctionParameters> function_map {};
+	TokenMap<FunctionParameters> function_map {func_index};
 
 	// Counter Defs
 	struct CounterParameters {
@@ -60,7 +83,23 @@ private:
 		std::string unit  {};
 	};
 	std::map<uint32_t, std::string> counter_group_map {};
-	std::map<uint32_t, CounterParameters> counter_map {};
+	TokenMap<CounterParameters> counter_map {counter_index};
+
+	// Source Code Location Defs
+	struct SclParameters {
+		uint32_t file {};
+		uint32_t line {};
+	};
+	std::map<uint32_t, std::string> scl_file_map {};
+	TokenMap<SclParameters> scl_map {scl_index};
+
+	// File Defs
+	struct FileParameters {
+		std::string name  {};
+		uint32_t    group {};
+	};
+	std::map<uint32_t, std::string> file_group_map {};
+	TokenMap<FileParameters> file_map {file_index};
 
 	// Message Statistics
 	struct MessageStatistics {
@@ -69,39 +108,84 @@ private:
 			uint64_t bytes {0};
 			uint64_t min   {std::numeric_limits<uint64_t>::max()};
 			uint64_t max   {std::numeric_limits<uint64_t>::min()};
-			std::map<uint64_t, uint64_t> sizemap {};
+			SizeHistogram sizes {};
 			void updateMinMax(uint64_t len)
 			{
 				min = len < min ? len : min;
 				max = len > max ? len : max;
 			}
+			void add(const std::vector<uint64_t> &lengths, bool exact)
+			{
+				uint64_t sum = 0, lo = min, hi = max;
+				for (auto len:lengths)
+				{
+					sum += len;
+					lo = len < lo ? len : lo;
+					hi = len > hi ? len : hi;
+				}
+				msgs  += lengths.size();
+				bytes += sum;
+				min = lo;
+				max = hi;
+
+				if (sizes.empty())
+					sizes = SizeHistogram(exact);
+				for (auto len:lengths)
+					sizes.add(len);
+			}
 		};
 		DirectionStats sent {};
 		DirectionStats recv {};
 	};
-	std::map<uint32_t, MessageStatistics> msg_stats {};
+	TokenMap<MessageStatistics> msg_stats {proc_index};
 
 	// Node idle (phases with no messages issued)
 	struct MessageGaps {
-		uint64_t min {std::numeric_limits<uint64_t>::max()};
-		uint64_t max {std::numeric_limits<uint64_t>::min()};
-		std::vector<uint64_t> avg {0};
-		uint64_t total {0};
+		uint64_t count {0}; // all gaps
+		uint64_t total {0}; // sum of all gaps
 
-		uint64_t last {0};
+		// streaming statistics of the gaps
+		uint64_t min  {std::numeric_limits<uint64_t>::max()};
+		uint64_t max  {std::numeric_limits<uint64_t>::min()};
+		double   mean {0.0}; // Welford
+		double   m2   {0.0};
+		LogHistogram hist {};
 
-		void update(uint64_t time)
+		void add(uint64_t gap)
 		{
-			// calculate gap to last event
-			auto gap = time - last;
-			last = time;
-
-			// update min/max/avg/total
 			min = gap < min ? gap : min;
 			max = gap > max ? gap : max;
 
-			avg.push_back(gap);
+			count++;
 			total += gap;
+			const double d = gap - mean;
+			mean += d / count;
+			m2   += d * (gap - mean);
+
+			hist.add(gap);
+		}
+
+		void merge(const MessageGaps &other)
+		{
+			if (other.count == 0)
+				return;
+
+			if (count == 0)
+			{
+				*this = other;
+				return;
+			}
+
+			const double nt = count + other.count;
+			const double d  = other.mean - mean;
+			mean += d * other.count / nt;
+			m2   += other.m2 + d * d * count * other.count / nt;
+
+			count += other.count;
+			total += other.total;
+			min = std::min(min, other.min);
+			max = std::max(max, other.max);
+			hist.merge(other.hist);
 		}
 
 		double getMin(void) { return min; }
@@ -110,11 +194,20 @@ private:
 
 		double getAvg(void)
 		{
-			double sum = 0.0;
-			for (auto x:avg)
-				sum += x;
+			return count ? static_cast<double>(total) / count : 0.0;
+		}
+
+		double getStdDev(void)
+		{
+			return count ? std::sqrt(m2 / count) : 0.0;
+		}
+
+		double getQuantile(double q)
+		{
+			if (count == 0)
+				return 0.0;
 
-			return (sum / avg.size());
+			return std::min(std::max(static_cast<double>(hist.quantile(q)), getMin()), getMax());
 		}
 
 		double getTot(void)
@@ -122,19 +215,104 @@ private:
 			return total;
 		}
 	};
-	std::map<uint32_t, MessageGaps> node_idle {};
+	TokenMap<MessageGaps> node_idle {proc_index};
+
+	// Matched point-to-point messages (latency in ns, effective bandwidth in bytes/s)
+	struct P2PStatistics {
+		uint64_t    msgs      {0};
+		uint64_t    bytes     {0};
+		MessageGaps latency   {};
+		MessageGaps bandwidth {};
 
-	// Function Statistics
+		void merge(const P2PStatistics &other)
+		{
+			msgs  += other.msgs;
+			bytes += other.bytes;
+			latency.merge(other.latency);
+			bandwidth.merge(other.bandwidth);
+		}
+	};
+	TokenMap<          // sender
+	std::map<uint32_t, // receiver
+	P2PStatistics
+	>> p2p_stats {proc_index};
+	P2PStatistics p2p_total {};
+	uint64_t p2p_negative    {0}; // received before sent (clock skew), no latency
+	uint64_t unmatched_sends {0};
+	uint64_t unmatched_recvs {0};
+
+	// Wait states (--wait-states, ns): receives posted before the matching
+	// send started (late sender), sends blocked until the receive was posted
+	// (late receiver). Attributed to the waiting process and its peer.
+	struct WaitStates {
+		uint64_t late_sender        {0};
+		uint64_t late_sender_msgs   {0};
+		uint64_t late_receiver      {0};
+		uint64_t late_receiver_msgs {0};
+	};
+	TokenMap<          // waiting process
+	std::map<uint32_t, // peer
+	WaitStates
+	>> wait_states {proc_index};
+	// calls left with sends that were not matched yet, by enter time
+	struct SendRegion {
+		uint64_t leave;
+		uint32_t sends;
+	};
+	TokenMap<std::map<uint64_t, SendRegion>> send_regions {proc_index};
+	// late receivers of sends whose call was still open, by enter of the call
+	struct LateReceiver {
+		uint64_t recv_enter;
+		uint32_t receiver;
+	};
+	TokenMap<std::multimap<uint64_t, LateReceiver>> late_receivers {proc_index};
+	void addLateReceiver(uint32_t sender, uint32_t receiver, uint64_t send_enter, uint64_t send_leave, uint64_t recv_enter);
+
+	// Function Statistics (ns, time is inclusive, excl exclusive)
 	struct FunctionStatistics {
-		uint64_t enter {std::numeric_limits<uint64_t>::max()};
 		uint64_t time  {0};
+		uint64_t excl  {0};
 		uint64_t calls {0};
 	};
-	std::map<uint32_t, // process
-	std::map<uint32_t, // group
-	std::map<uint32_t, // function
+	TokenMap<          // process
+	TokenMap<          // function
 	FunctionStatistics
-	>>> fkt_stats {};
+	>> fkt_stats {proc_index};
+	FunctionStatistics& getFktStats(uint32_t proc, uint32_t func);
+
+	// Call stacks, a call is accounted for when it is left
+	struct CallFrame {
+		uint64_t enter;
+		uint64_t child; // inclusive time of the calls made from this one
+		uint32_t func;
+		uint32_t node;  // calling-context tree node, CallTree::none without --cct
+		uint32_t sends; // sends from this call not matched yet (--wait-states)
+		bool     outer; // no call of the same function below, adds to the inclusive time
+	};
+	// leave of a call entered before the part of the trace read by this instance
+	struct OpenLeave {
+		uint64_t time;
+		uint64_t child;
+		uint32_t func;
+	};
+	struct CallStack {
+		std::vector<CallFrame> frames {};
+		uint64_t base_child {0};          // time of the completed calls below the first frame
+		std::vector<OpenLeave> leaves {}; // closed by a merge with the preceding part
+		TokenMap<uint32_t> open {};       // calls in progress per function
+		// inclusive time of the completed outer calls per function, by the
+		// number of open leaves before them: a call of the same function
+		// open in the preceding part makes them inner calls
+		std::vector<TokenMap<uint64_t>> outer_done {};
+		CallTree tree {};
+	};
+	TokenMap<CallStack> call_stacks {proc_index};
+	CallStack& getCallStack(uint32_t proc);
+	TokenMap<uint64_t>& outerDone(CallStack &stack);
+	uint64_t unmatched_leaves {0};
+	void leaveCall(uint32_t proc, CallStack &stack, uint32_t func, uint64_t time);
+	static size_t leaveDepth(const std::vector<CallFrame> &frames, uint32_t func); // frames up to the left call, 0 if func is not open
+	void leaveSendRegion(uint32_t proc, const CallFrame &f, uint64_t time);
 
 	// Collective Defs
 	struct CollectiveParameters {
@@ -148,20 +326,125 @@ private:
 		uint64_t sent  {0};
 		uint64_t recv  {0};
 		uint64_t calls {0};
+
+		// matched instances (ns): earliest enter to latest exit, time in
+		// the collective and time waiting for the last one summed over the participants
+		uint64_t instances    {0};
+		uint64_t time         {0};
+		uint64_t max_time     {0};
+		uint64_t participants {0};
+		uint64_t proc_time    {0};
+		uint64_t wait         {0};
 	};
 
-	std::map<uint32_t, // communicator
+	TokenMap<          // communicator
 	std::map<uint32_t, // op
 	CollectiveStatistics
-	>> coll_stats {};
+	>> coll_stats {comm_index};
+	TokenMap<uint64_t> coll_wait {proc_index}; // ns, arrival skew
+
+	// Communication matrix (--comm-matrix), collective bytes are spread over
+	// the participants of a communicator when written
+	CommMatrix comm_p2p {proc_index};
+	struct CollectiveBytes {
+		uint64_t sent  {0};
+		uint64_t recv  {0};
+		uint64_t sends {0}; // calls that sent data
+	};
+	TokenMap<          // communicator
+	std::map<uint32_t, // process
+	CollectiveBytes
+	>> coll_bytes {comm_index};
+	const size_t coll_matrix_members {4096}; // larger communicators are left out of the matrix
+	uint64_t unfinished_colls {0};
+	uint64_t unmatched_coll_ends {0};
+
+	// Communication per call site (--call-sites), by the SCL token of the events
+	struct CallSiteStatistics {
+		uint64_t calls      {0}; // function calls entered here
+		uint64_t sent       {0};
+		uint64_t sent_bytes {0};
+		uint64_t recv       {0};
+		uint64_t recv_bytes {0};
+		uint64_t colls      {0};
+		uint64_t coll_bytes {0}; // sent and received
+		uint64_t msgs(void) const  { return sent + recv + colls; }
+		uint64_t bytes(void) const { return sent_bytes + recv_bytes + coll_bytes; }
+	};
+	TokenMap<CallSiteStatistics> site_stats {scl_index};
+
+	// One-sided communication (--rma)
+	RmaStats rma {};
+
+	// File I/O (--file-io), from the completed file operations, times in ns
+	struct FileIoStatistics {
+		uint64_t reads       {0};
+		uint64_t read_bytes  {0};
+		uint64_t read_time   {0};
+		uint64_t writes      {0};
+		uint64_t write_bytes {0};
+		uint64_t write_time  {0};
+		uint64_t others      {0}; // open, close, seek, ...
+		uint64_t other_time  {0};
+		void add(uint32_t op, uint64_t bytes, uint64_t time);
+		void merge(const FileIoStatistics &other);
+	};
+	TokenMap<FileIoStatistics> io_procs {proc_index};
+	TokenMap<FileIoStatistics> io_files {file_index};
+	uint64_t unmatched_io_begins {0};
+	uint64_t unmatched_io_ends   {0};
+	std::string getFileName(uint32_t file);
+	std::string getSclName(uint32_t scl);
 
 	// Performance Counter
-	std::map<uint32_t, std::map<std::string, uint64_t>> papi_counter {};
+	// PAPI counters get a dense slot when they are defined, others are ignored
+	enum PapiKnown : uint32_t {PAPI_FP_OPS, PAPI_FP_INS, PAPI_TOT_CYC, PAPI_KNOWN};
+	struct PapiValues {
+		std::vector<uint64_t> value    {};
+		std::vector<uint8_t>  recorded {};
+	};
+	std::vector<std::string> papi_names {}; // slot -> counter name
+	std::vector<uint32_t>    papi_slots {}; // dense counter index -> slot
+	uint32_t papi_known[PAPI_KNOWN] {TokenIndex::npos, TokenIndex::npos, TokenIndex::npos};
+	TokenMap<PapiValues> papi_counter {proc_index};
+	uint64_t getPapiValue(uint32_t proc, PapiKnown counter);
+
+	// Summary records (values are cumulative, the latest record of a key is used)
+	struct FunctionSummary {
+		uint64_t time        {0};
+		uint64_t invocations {0};
+		uint64_t excl        {0};
+		uint64_t incl        {0};
+	};
+	struct MessageSummary {
+		uint64_t time      {0};
+		uint64_t sent      {0};
+		uint64_t recv      {0};
+		uint64_t sentBytes {0};
+		uint64_t recvBytes {0};
+	};
+	std::map<uint32_t, // process
+	std::map<uint32_t, // function
+	FunctionSummary
+	>> fkt_summary {};
+
+	std::map<uint32_t, // process
+	std::map<std::tuple<uint32_t, uint32_t, uint32_t>, // peer, communicator, type
+	MessageSummary
+	>> msg_summary {};
+
+	std::map<uint32_t, // process
+	std::map<std::pair<uint32_t, uint32_t>, // communicator, op
+	MessageSummary
+	>> coll_summary {};
 
 public:
 	TraceStats(std::shared_ptr<Config> cfg);
 	~TraceStats();
 
+	// shared with the data of the other classes keyed by process
+	std::shared_ptr<const TokenIndex> getProcessIndex(void) const { return proc_index; }
+
 	// Definitions
 	void addOtfCreator(std::string creator);
 	void addOtfTimeRange(uint64_t begin, uint64_t end);
@@ -174,14 +457,45 @@ public:
 	void addCounterGroup(uint32_t id, std::string name);
 	void addCounter(uint32_t id, std::string name, std::string unit, uint32_t group);
 	void addCollective(uint32_t id, uint32_t type, std::string name);
-	void addPapiCounter(uint32_t proc, uint32_t counter, uint64_t value);
+	void addSclFile(uint32_t id, std::string name);
+	void addFileGroup(uint32_t id, std::string name);
+	void addFile(uint32_t id, std::string name, uint32_t group);
+	void addScl(uint32_t id, uint32_t file, uint32_t line);
+	uint32_t addPapiCounter(uint32_t proc, uint32_t counter, uint64_t value); // PAPI slot or npos
 
 	// Events
-	void addCollectiveEvent(uint32_t proc, uint32_t communicator, uint32_t operation, uint32_t sent, uint32_t recv, uint64_t time);
-	void addSendMsg(uint32_t proc, uint32_t len, uint64_t time);
-	void addRecvMsg(uint32_t proc, uint32_t len, uint64_t time);
+	void addSendBatch(uint32_t proc, const MessageBatch::P2P &batch);
+	void addRecvBatch(uint32_t proc, const MessageBatch::P2P &batch);
+	void addCollBatch(uint32_t proc, const MessageBatch::Collective &batch);
+	void addMessageBatch(uint32_t proc, const MessageBatch &batch);
+	void addMatrixBatch(uint32_t proc, const MessageBatch &batch);
+	void addIdleGaps(uint32_t proc, const ActivityTracker::Gaps &gaps);
+	uint64_t messageRegion(uint32_t proc, uint64_t time, bool send);
+	void addMessageMatch(const MessageMatcher::Match &match);
+	void addWaitStates(const MessageMatcher::Match &match);
+	void addSendRegionLeave(uint32_t proc, uint32_t func, uint64_t time);
+	void setUnmatchedMessages(uint64_t sends, uint64_t recvs);
+	void addCollectiveInstance(const CollectiveTracker::Instance &instance);
+	void setUnfinishedCollectives(uint64_t instances, uint64_t ends);
 	void addFktEnter(uint32_t proc, uint32_t func, uint64_t time);
+	void addCctEnter(uint32_t proc);
 	void addFktLeave(uint32_t proc, uint32_t func, uint64_t time);
+	void addSiteCall(uint32_t scl);
+	void addSiteSend(uint32_t scl, uint64_t bytes);
+	void addSiteRecv(uint32_t scl, uint64_t bytes);
+	void addSiteCollective(uint32_t scl, uint64_t sent, uint64_t recv);
+	void addRmaPut(uint32_t origin, uint32_t target, uint64_t bytes);
+	void addRmaGet(uint32_t origin, uint32_t target, uint64_t bytes);
+	void addRmaEnd(uint32_t proc);
+	void applyRma(void);
+	void addFileOperation(const FileOpTracker::Operation &op);
+	void setUnmatchedFileOps(uint64_t begins, uint64_t ends);
+
+	// Summaries
+	void addFunctionSummary(uint32_t proc, uint32_t func, uint64_t time, uint64_t invocations, uint64_t excl, uint64_t incl);
+	void addMessageSummary(uint32_t proc, uint32_t peer, uint32_t communicator, uint32_t type, uint64_t time, uint64_t sent, uint64_t recv, uint64_t sentBytes, uint64_t recvBytes);
+	void addCollopSummary(uint32_t proc, uint32_t communicator, uint32_t operation, uint64_t time, uint64_t sent, uint64_t recv, uint64_t sentBytes, uint64_t recvBytes);
+	void applySummaries(void);
 
 	// Global stuff
 	OTF_Trace_Param getOtfParam(void);
@@ -205,6 +519,7 @@ public:
 	uint32_t    getCollectiveType(uint32_t collid);
 
 	uint32_t                     getCommunicatorSize(uint32_t groupid);
+	std::map<uint32_t, uint32_t> getMembersAmong(const std::vector<uint32_t> &procs);
 	std::set<uint32_t>           getCollectiveCommunicators(void);
 	std::map<uint32_t, uint32_t> getCollectiveCommunicatorsMap(void);
 
@@ -222,17 +537,37 @@ public:
 	double      getFunctionTime(uint32_t pid, uint32_t fid);
 	uint64_t    getFlops(uint32_t proc);
 
+	// PAPI counter slots, npos for other counters
+	uint32_t    getPapiSlot(uint32_t cid);
+	const std::vector<std::string>& getPapiNames(void) const;
+
 private:
 	std::string map2table(const std::string title, std::map<uint32_t, std::string>& container);
-	std::string map2table(const std::string title, std::map<uint32_t, ProcessParameters>& container);
+	std::string map2table(const std::string title, TokenMap<ProcessParameters>& container);
 	std::string map2table(const std::string title, std::map<uint32_t, ProcessGroupParameters>& container);
-	std::string map2table(const std::string title, std::map<uint32_t, FunctionParameters>& container);
-	std::string map2table(const std::string title, std::map<uint32_t, CounterParameters>& container);
-	std::string msgs2table(const std::string title, std::map<uint32_t, MessageStatistics>& container);
-	std::string fkts2table(const std::string title, std::map<uint32_t,std::map<uint32_t,std::map<uint32_t, FunctionStatistics>>>& container);
-	std::string coll2table(const std::string title, std::map<uint32_t, std::map<uint32_t, CollectiveStatistics>>& container);
+	std::string map2table(const std::string title, TokenMap<FunctionParameters>& container);
+	std::string map2table(const std::string title, TokenMap<CounterParameters>& container);
+	std::string msgs2table(const std::string title, TokenMap<MessageStatistics>& container);
+	std::string fkts2table(const std::string title, TokenMap<TokenMap<FunctionStatistics>>& container);
+	std::string coll2table(const std::string title, TokenMap<std::map<uint32_t, CollectiveStatistics>>& container);
+	void writeCallTrees(void);
+	std::string p2p2table(const std::string title);
+	std::string wait2table(const std::string title);
+	std::string sites2table(const std::string title);
+	std::string rma2table(const std::string title);
+	std::string io2table(const std::string title);
+	std::string matrix2table(const std::string title);
+	void writeFileIo(void);
+	void writeRma(void);
+	void writeCallSites(void);
+	void writeWaitStates(void);
+	void writeP2PPairs(void);
+	void writeCommMatrix(void);
 
 public:
+	bool needsTimeOrder(void) const;
+	bool needsWholeProcesses(void) const; // no time slices
+	void merge(const TraceStats &other);
 	void print(void);
 	bool validate(const bool printErrors);
 };
@@ -14,11 +14,19 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include <globals.h>
 #include <config.h>
 #include <make_unique.h>
 #include <trace_stats.h>
+#include <message_batch.h>
+#include <activity_tracker.h>
+#include <file_op_tracker.h>
+#include <token_map.h>
+#include <size_histogram.h>
 
 class TraceVisualizer {
 private:
@@ -29,16 +37,23 @@ private:
 	const std::string gnuplot_inj_filename_prefix {"inj-p"};
 	const std::string gnuplot_cdf_filename_prefix {"cdf-p"};
 	const std::string gnuplot_iahist_filename_prefix {"iahist-p"};
+	const std::string gnuplot_iaraw_filename_prefix {"iaraw-p"};
+	const std::string gnuplot_ctr_filename_prefix {"ctr-p"};
+	const std::string gnuplot_io_filename_prefix {"io-p"};
 	bool gnuplot_present {false};
 	bool rscript_present {false};
+	bool is_shard        {false}; // partial results of a parallel run, no output
 
 	std::shared_ptr<Config>     config;
 	std::shared_ptr<TraceStats> stats;
 
 public:
-	TraceVisualizer(std::shared_ptr<Config> cfg, std::shared_ptr<TraceStats> ts);
+	TraceVisualizer(std::shared_ptr<Config> cfg, std::shared_ptr<TraceStats> ts, bool shard=false);
 	~TraceVisualizer();
 
+	bool needsTimeOrder(void) const;
+	void merge(const TraceVisualizer &other);
+
 // message injection diagrams
 private:
 	struct InjData {
@@ -47,30 +62,85 @@ private:
 		uint64_t bytes;
 	};
 	enum Direction {P2P_SEND, P2P_RECV, COLL_SEND, COLL_RECV};
-	std::map<uint32_t, std::map<Direction, std::vector<InjData>>> injections {};
+	TokenMap<std::map<Direction, std::vector<InjData>>> injections {};
+
+	// messages per fixed-width time bin, used instead of injections with --inj-bins
+	struct InjBin {
+		uint64_t count {0};
+		uint64_t bytes {0};
+		uint64_t min   {std::numeric_limits<uint64_t>::max()};
+		uint64_t max   {0};
+	};
+	TokenMap<std::map<Direction, std::vector<InjBin>>> injection_bins {};
+	void addInjection(std::vector<InjBin> &bins, uint64_t time, uint64_t bytes);
+	void writeInjData(std::ostream &out, const std::vector<InjData> &data);
+	void writeInjBins(std::ostream &out, const std::vector<InjBin> &bins);
 
 // inactivity periods
 private:
-	std::map<uint32_t, uint64_t> lastActivity {};
-	std::map<uint32_t, std::vector<uint64_t>> inactivity_periods {};
+	// bin counts of the inactivity periods per process, counts[0] holds the
+	// periods below the first edge, counts[n+1] those beyond the last
+	std::vector<uint64_t> inactivity_edges {}; // bin edges in ns, linear or logarithmic
+	uint32_t inactivityBin(uint64_t period) const;
+
+	TokenMap<std::vector<uint64_t>> inactivity {};
+	TokenMap<std::vector<uint64_t>> inactivity_periods {}; // raw periods, only with --iahist-raw
 public:
-	void updateInactPeriods(uint32_t proc, uint64_t time);
 	void makeInactivityHistogram(std::string dirname);
 
 public:
-	void addSendP2P(uint32_t proc, uint64_t time, uint64_t bytes);
-	void addRecvP2P(uint32_t proc, uint64_t time, uint64_t bytes);
-	void addColl(uint32_t proc, uint64_t time, uint64_t sent, uint64_t recv);
+	void addSendBatch(uint32_t proc, const MessageBatch::P2P &batch);
+	void addRecvBatch(uint32_t proc, const MessageBatch::P2P &batch);
+	void addCollBatch(uint32_t proc, const MessageBatch::Collective &batch);
+	void addMessageBatch(uint32_t proc, const MessageBatch &batch);
+	void addInactivityGaps(uint32_t proc, const ActivityTracker::Gaps &gaps);
 	void makeInjPlot(std::string dirname);
 
+// PAPI counter rates
+private:
+	// rates (delta value / delta time) of the samples ending in a time bin
+	struct CounterBin {
+		uint64_t samples {0};
+		uint64_t delta   {0}; // sum of value deltas
+		uint64_t ticks   {0}; // sum of time deltas
+		double   min     {std::numeric_limits<double>::max()}; // per second
+		double   max     {0.0};
+	};
+	// the first sample has no rate, it is kept for a merge with an earlier part
+	struct CounterSeries {
+		uint64_t first_time  {0};
+		uint64_t first_value {0};
+		uint64_t last_time   {0};
+		uint64_t last_value  {0};
+		bool     active      {false};
+		std::vector<CounterBin> bins {};
+	};
+	TokenMap<std::vector<CounterSeries>> counter_series {}; // per process and PAPI slot
+	void addCounterRate(CounterSeries &cs, uint64_t time, uint64_t value);
+public:
+	void addCounterSample(uint32_t proc, uint32_t slot, uint64_t time, uint64_t value); // slot of TraceStats::addPapiCounter
+	void makeCounterPlot(std::string dirname);
+
+// file I/O timeline
+private:
+	// bytes per time bin of the operation begins, binned like injections
+	enum IoDirection {IO_READ, IO_WRITE};
+	TokenMap<std::map<IoDirection, std::vector<InjBin>>> io_bins {};
+public:
+	void addFileOperation(const FileOpTracker::Operation &op);
+	void makeIoPlot(std::string dirname);
+
+// communication matrix heatmaps, of the dense tables written by TraceStats
+public:
+	void makeCommMatrixPlot(std::string dirname);
+
 // message CDF diagrams
 private:
 	enum MsgType {P2P, COLL};
-	std::map<uint32_t, std::map<MsgType, std::map<uint64_t, uint64_t>>> messages_cdf {};
-	std::map<MsgType, std::map<uint64_t, uint64_t>> messages_cdf_allnodes {};
+	TokenMap<std::map<MsgType, SizeHistogram>> messages_cdf {};
+	std::map<MsgType, SizeHistogram> messages_cdf_allnodes {};
+	void writeCdfData(std::ostream &out, const SizeHistogram &sizes);
 public:
-	void addMessageCDF_P2P(uint32_t proc, uint64_t msg_len);
-	void addMessageCDF_COLL(uint32_t proc, uint64_t msg_len);
 	void makeCdfPlot(std::string dirname);
 };
 
@@ -0,0 +1,86 @@
+#include <activity_tracker.h>
+
+ActivityTracker::ActivityTracker(std::shared_ptr<const TokenIndex> procs, bool shard) :
+	is_shard(shard),
+	activity(procs)
+{
+#ifdef DEBUG
+	ctor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+ActivityTracker::~ActivityTracker()
+{
+#ifdef DEBUG
+	dtor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+void ActivityTracker::subscribe(Subscriber s)
+{
+	subscribers.push_back(s);
+}
+
+void ActivityTracker::publish(uint32_t proc)
+{
+	if (!gaps.gap.empty())
+		for (const auto &s:subscribers)
+			s(proc, gaps);
+
+	gaps.gap.clear();
+	gaps.type.clear();
+}
+
+void ActivityTracker::addMessageBatch(uint32_t proc, const MessageBatch &batch)
+{
+	if (batch.size() == 0)
+		return;
+
+	auto &a = activity[proc];
+	batch.forEach([this, &a](uint64_t time, uint8_t type)
+	{
+		if (!a.active && is_shard)
+		{
+			a.first = time;
+			a.first_type = type;
+		}
+		else
+		{
+			gaps.gap.push_back(time - a.last);
+			gaps.type.push_back(type);
+		}
+
+		a.last = time;
+		a.active = true;
+	});
+
+	publish(proc);
+}
+
+void ActivityTracker::merge(const ActivityTracker &other)
+{
+	// a tracker that is no shard has handed out all of its gaps already
+	for (const auto &p:other.activity)
+	{
+		const auto &o = p.second;
+		if (!o.active)
+			continue;
+
+		auto &a = activity[p.first];
+		if (other.is_shard && is_shard && !a.active)
+		{
+			a.first = o.first;
+			a.first_type = o.first_type;
+		}
+		else if (other.is_shard)
+		{
+			// the held back gap of other, re-based on our last event
+			gaps.gap.push_back(o.first - a.last);
+			gaps.type.push_back(o.first_type);
+			publish(p.first);
+		}
+
+		a.last = o.last;
+		a.active = true;
+	}
+}
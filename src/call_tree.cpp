@@ -0,0 +1,92 @@
+#include <call_tree.h>
+
+uint32_t CallTree::alloc(uint32_t parent, uint32_t func)
+{
+	if ((nodes & (block_size-1)) == 0)
+	{
+		blocks.emplace_back();
+		blocks.back().reserve(block_size);
+	}
+
+	blocks.back().emplace_back();
+	blocks.back().back().parent = parent;
+	blocks.back().back().func   = func;
+	return nodes++;
+}
+
+uint32_t CallTree::child(uint32_t parent, uint32_t func)
+{
+	// inline children first, then the overflow blocks
+	for (uint32_t i=0; i<inline_children; i++)
+	{
+		const uint32_t c = node(parent).child[i];
+		if (c == none)
+		{
+			const uint32_t n = alloc(parent, func);
+			node(parent).child[i] = n;
+			return n;
+		}
+		if (node(c).func == func)
+			return c;
+	}
+
+	// a new block is linked from the node or from the previous block, by
+	// index: emplace_back() may move the blocks
+	uint32_t prev = none;
+	uint32_t b    = node(parent).more;
+	while (true)
+	{
+		if (b == none)
+		{
+			overflow.emplace_back();
+			b = overflow.size()-1;
+			if (prev == none)
+				node(parent).more = b;
+			else
+				overflow[prev].next = b;
+		}
+
+		for (uint32_t i=0; i<overflow_children; i++)
+		{
+			const uint32_t c = overflow[b].child[i];
+			if (c == none)
+			{
+				const uint32_t n = alloc(parent, func);
+				overflow[b].child[i] = n;
+				return n;
+			}
+			if (node(c).func == func)
+				return c;
+		}
+
+		prev = b;
+		b    = overflow[b].next;
+	}
+}
+
+uint32_t CallTree::base(size_t epoch)
+{
+	while (bases.size() <= epoch)
+		bases.push_back(alloc(none, none));
+	return bases[epoch];
+}
+
+void CallTree::graft(uint32_t n, const CallTree &other, uint32_t other_node, std::vector<uint32_t> &map)
+{
+	if (map.size() < other.size())
+		map.resize(other.size(), none);
+
+	other.forEachChild(other_node, [&](uint32_t oc)
+	{
+		const Node &o = other.node(oc);
+		const uint32_t c = child(n, o.func);
+
+		Node &t = node(c);
+		t.calls += o.calls;
+		t.incl  += o.incl;
+		t.excl  += o.excl;
+		map[oc] = c;
+
+		graft(c, other, oc, map);
+	});
+}
@@ -0,0 +1,176 @@
+#include <collective_tracker.h>
+
+CollectiveTracker::CollectiveTracker(std::shared_ptr<const TokenIndex> procs) :
+	entered(procs)
+{
+#ifdef DEBUG
+	ctor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+CollectiveTracker::~CollectiveTracker()
+{
+#ifdef DEBUG
+	dtor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+void CollectiveTracker::subscribe(Subscriber s)
+{
+	subscribers.push_back(s);
+}
+
+void CollectiveTracker::own(const std::map<uint32_t, uint32_t> &members)
+{
+	// the processes read before are done, their instances are complete or open
+	owned_members = FlatHashMap<uint64_t, uint32_t, IdHash>(64);
+	for (const auto &m:members)
+		owned_members[m.first] = m.second;
+}
+
+uint32_t CollectiveTracker::instance(uint64_t id, uint32_t comm, uint32_t op, uint32_t expected)
+{
+	const uint32_t *found = ids.get(id);
+	if (found != nullptr)
+		return *found;
+
+	uint32_t n;
+	if (!free_instances.empty())
+	{
+		n = free_instances.back();
+		free_instances.pop_back();
+	}
+	else
+	{
+		n = instances.size();
+		instances.emplace_back();
+	}
+
+	auto &inst = instances[n];
+	inst.id       = id;
+	inst.comm     = comm;
+	inst.op       = op;
+	inst.expected = expected;
+	inst.open     = 0;
+
+	ids[id] = n;
+	return n;
+}
+
+void CollectiveTracker::complete(uint64_t id, bool force)
+{
+	const uint32_t n = *ids.get(id);
+	auto &inst = instances[n];
+	if (inst.open > 0)
+		return;
+	if (!force && (inst.expected == 0 || inst.participants.size() < inst.expected))
+	{
+		// all owned members have left: the rest is in other shards
+		const uint32_t *members = owned_members.get(inst.comm);
+		if (members == nullptr || inst.participants.size() < *members)
+			return;
+
+		parts.push_back({id, inst.comm, inst.op, inst.expected, static_cast<uint32_t>(part_participants.size()), static_cast<uint32_t>(inst.participants.size())});
+		part_participants.insert(part_participants.end(), inst.participants.begin(), inst.participants.end());
+		inst.participants.clear();
+		free_instances.push_back(n);
+		ids.erase(id);
+		return;
+	}
+
+	for (const auto &f:subscribers)
+		f(inst);
+
+	// the instance keeps its participants' capacity for reuse
+	inst.participants.clear();
+	free_instances.push_back(n);
+	ids.erase(id);
+}
+
+bool CollectiveTracker::leave(uint32_t proc, uint64_t id, uint64_t time)
+{
+	auto &e = entered[proc];
+	for (size_t k=e.size(); k-- > 0;)
+	{
+		if (e[k].id != id)
+			continue;
+
+		const uint32_t p = e[k].participant;
+		e.erase(e.begin() + k);
+
+		auto &inst = instances[*ids.get(id)];
+		inst.participants[p].exit = time;
+		inst.open--;
+
+		complete(id);
+		return true;
+	}
+
+	return false;
+}
+
+void CollectiveTracker::addBegin(uint32_t proc, uint64_t time, uint64_t id, uint32_t comm, uint32_t op, uint32_t expected)
+{
+	auto &inst = instances[instance(id, comm, op, expected)];
+	inst.participants.push_back({proc, time, time});
+	inst.open++;
+
+	entered[proc].push_back({id, static_cast<uint32_t>(inst.participants.size() - 1)});
+}
+
+void CollectiveTracker::addEnd(uint32_t proc, uint64_t time, uint64_t id)
+{
+	if (!leave(proc, id, time))
+		open_ends.push_back({proc, id, time});
+}
+
+void CollectiveTracker::merge(const CollectiveTracker &other)
+{
+	// participants of other join our instances, their indices move by the offset
+	std::map<uint64_t, uint32_t> offsets;
+	other.ids.forEach([this, &other, &offsets](uint64_t, uint32_t n)
+	{
+		const auto &o = other.instances[n];
+		auto &inst = instances[instance(o.id, o.comm, o.op, o.expected)];
+		offsets[o.id] = inst.participants.size();
+		inst.participants.insert(inst.participants.end(), o.participants.begin(), o.participants.end());
+		inst.open += o.open;
+	});
+
+	// finished parts of other join the instances of the same id
+	for (const auto &p:other.parts)
+	{
+		auto &inst = instances[instance(p.id, p.comm, p.op, p.expected)];
+		const auto first = other.part_participants.begin() + p.first;
+		inst.participants.insert(inst.participants.end(), first, first + p.n);
+	}
+
+	// collectives left in other but entered here
+	for (const auto &e:other.open_ends)
+		if (!leave(e.proc, e.id, e.time))
+			open_ends.push_back(e);
+
+	for (const auto &p:other.entered)
+		for (const auto &e:p.second)
+			entered[p.first].push_back({e.id, offsets[e.id] + e.participant});
+
+	for (const auto &o:offsets)
+		if (ids.get(o.first) != nullptr)
+			complete(o.first);
+	for (const auto &p:other.parts)
+		if (ids.get(p.id) != nullptr)
+			complete(p.id);
+}
+
+void CollectiveTracker::finish(void)
+{
+	std::vector<uint64_t> left;
+	ids.forEach([this, &left](uint64_t id, uint32_t n)
+	{
+		if (instances[n].open == 0)
+			left.push_back(id);
+	});
+
+	for (auto id:left)
+		complete(id, true);
+}
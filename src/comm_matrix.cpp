@@ -0,0 +1,143 @@
+#include <comm_matrix.h>
+
+void CommMatrix::compact(Row &row)
+{
+	auto &tail = row.tail;
+	std::sort(tail.begin(), tail.end(), [](const Cell &a, const Cell &b) { return a.col < b.col; });
+
+	// add up the cells of a column, then merge with the sorted part
+	std::vector<Cell> merged;
+	merged.reserve(row.sorted.size() + tail.size());
+	auto s = row.sorted.begin();
+	for (size_t i=0; i<tail.size(); i++)
+	{
+		while (s != row.sorted.end() && s->col < tail[i].col)
+			merged.push_back(*s++);
+
+		if (!merged.empty() && merged.back().col == tail[i].col)
+		{
+			merged.back().msgs  += tail[i].msgs;
+			merged.back().bytes += tail[i].bytes;
+		}
+		else if (s != row.sorted.end() && s->col == tail[i].col)
+		{
+			merged.push_back(*s++);
+			merged.back().msgs  += tail[i].msgs;
+			merged.back().bytes += tail[i].bytes;
+		}
+		else
+		{
+			merged.push_back(tail[i]);
+		}
+	}
+	merged.insert(merged.end(), s, row.sorted.end());
+
+	row.sorted.swap(merged);
+	tail.clear();
+}
+
+void CommMatrix::merge(const CommMatrix &other)
+{
+	for (const auto &r:other.rows)
+	{
+		for (const auto &c:r.second.sorted)
+			add(r.first, c.col, c.msgs, c.bytes);
+		for (const auto &c:r.second.tail)
+			add(r.first, c.col, c.msgs, c.bytes);
+	}
+}
+
+void CommMatrix::writeBinary(const std::string &filename)
+{
+	for (auto &r:rows)
+		compact(r.second);
+
+	// rows and columns of all processes that sent or received
+	std::map<uint32_t, uint32_t> index;
+	for (const auto &r:rows)
+	{
+		index[r.first] = 0;
+		for (const auto &c:r.second.sorted)
+			index[c.col] = 0;
+	}
+
+	std::vector<uint32_t> procs;
+	for (auto &i:index)
+	{
+		i.second = procs.size();
+		procs.push_back(i.first);
+	}
+
+	std::vector<uint64_t> offsets(procs.size() + 1, 0);
+	for (const auto &r:rows)
+		offsets[index[r.first] + 1] = r.second.sorted.size();
+	for (size_t i=1; i<offsets.size(); i++)
+		offsets[i] += offsets[i-1];
+
+	const uint64_t n = procs.size(), nnz = offsets.back();
+	std::vector<uint32_t> cols(nnz);
+	std::vector<uint64_t> msgs(nnz), bytes(nnz);
+	for (const auto &r:rows)
+	{
+		uint64_t k = offsets[index[r.first]];
+		for (const auto &c:r.second.sorted)
+		{
+			cols[k]  = index[c.col];
+			msgs[k]  = c.msgs;
+			bytes[k] = c.bytes;
+			k++;
+		}
+	}
+
+	std::ofstream out(filename, std::ofstream::out | std::ofstream::binary);
+	if (!out)
+		throw std::runtime_error("Cannot write '" + filename + "'");
+
+	out.write("SONARCM1", 8);
+	out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+	out.write(reinterpret_cast<const char*>(&nnz), sizeof(nnz));
+	out.write(reinterpret_cast<const char*>(procs.data()), n * sizeof(uint32_t));
+	out.write(reinterpret_cast<const char*>(offsets.data()), (n + 1) * sizeof(uint64_t));
+	out.write(reinterpret_cast<const char*>(cols.data()), nnz * sizeof(uint32_t));
+	out.write(reinterpret_cast<const char*>(msgs.data()), nnz * sizeof(uint64_t));
+	out.write(reinterpret_cast<const char*>(bytes.data()), nnz * sizeof(uint64_t));
+	out.close();
+}
+
+void CommMatrix::writeCsv(const std::string &filename)
+{
+	for (auto &r:rows)
+		compact(r.second);
+
+	std::map<uint32_t, uint32_t> index;
+	for (const auto &r:rows)
+	{
+		index[r.first] = 0;
+		for (const auto &c:r.second.sorted)
+			index[c.col] = 0;
+	}
+	uint32_t n = 0;
+	for (auto &i:index)
+		i.second = n++;
+
+	std::ofstream out(filename, std::ofstream::out);
+	out << "sender/receiver";
+	for (const auto &i:index)
+		out << ',' << i.first;
+	out << '\n';
+
+	std::vector<uint64_t> line(n);
+	for (const auto &i:index)
+	{
+		std::fill(line.begin(), line.end(), 0);
+		if (rows.count(i.first))
+			for (const auto &c:rows[i.first].sorted)
+				line[index[c.col]] = c.bytes;
+
+		out << i.first;
+		for (auto b:line)
+			out << ',' << b;
+		out << '\n';
+	}
+	out.close();
+}
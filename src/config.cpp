@@ -32,6 +32,29 @@ static void usage(const char* prog)
 			<< "  -r | --rawotf   - show unmodified content of OTF-trace" << '\n'
 			<< "  -p | --progress - show progress" << '\n'
 			<< "  -s | --toscreen - print results to screen" << '\n'
+			<< "  -t | --threads N - read the event streams with N threads in parallel" << '\n'
+			<< "  -k | --slices K - split the trace into K time slices read in parallel (see -t)" << '\n'
+			<< "  -u | --unsorted - read events stream by stream instead of in global time order" << '\n'
+			<< "  --summary-only  - build the stats from the summary records only, skip all events" << '\n'
+			<< "  --no-functions  - skip the function and counter statistics" << '\n'
+			<< "  --no-messages   - skip the message statistics, matching and inactivity histograms" << '\n'
+			<< "  --no-collectives - skip the collective statistics" << '\n'
+			<< "  --no-plots      - skip the injection and CDF plots" << '\n'
+			<< "  -c | --cache    - cache the decoded events next to the trace and reuse them in later runs" << '\n'
+			<< "  --pipeline      - decode the events on a separate thread from the analysis" << '\n'
+			<< "  --iahist-bins N - number of bins of the inactivity histograms (default 50)" << '\n'
+			<< "  --iahist-max US - upper end of the inactivity histograms in us (default 500)" << '\n'
+			<< "  --iahist-log    - logarithmic inactivity bins from 1 ns to the upper end" << '\n'
+			<< "  --iahist-raw    - also write every inactivity period (large output)" << '\n'
+			<< "  --inj-bins N    - aggregate the injection plots into N time bins per process" << '\n'
+			<< "  --exact-sizes   - count every distinct message size instead of size ranges" << '\n'
+			<< "  --ctr-bins N    - time bins of the PAPI counter rate plots (default 0 = off)" << '\n'
+			<< "  --cct           - calling-context tree profile (cct.folded, cct.csv)" << '\n'
+			<< "  --comm-matrix   - process-to-process communication matrix (comm_matrix_*)" << '\n'
+			<< "  --wait-states   - late sender/receiver times of point-to-point messages (no time slices)" << '\n'
+			<< "  --call-sites N  - top N source locations by bytes and messages (call_sites.csv, 0 = off)" << '\n'
+			<< "  --rma           - one-sided communication statistics (rma_*), added to the message totals" << '\n'
+			<< "  --file-io       - file I/O per process and file (io_*), timeline in --inj-bins bins (default 100)" << '\n'
 			<< std::endl;
 }
 
@@ -90,6 +113,147 @@ Config::Config(const int argc, const char* argv[])
 			{
 				_stats_toscreen = true;
 			}
+			else if (!strcmp("--threads", argv[i]) || !strcmp("-t", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing number of threads for '" + (std::string)argv[i] + "'");
+
+				const int n = std::atoi(argv[++i]);
+				if (n < 1)
+					throw std::invalid_argument("Invalid number of threads: '" + (std::string)argv[i] + "'");
+
+				_threads = n;
+			}
+			else if (!strcmp("--slices", argv[i]) || !strcmp("-k", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing number of slices for '" + (std::string)argv[i] + "'");
+
+				const int n = std::atoi(argv[++i]);
+				if (n < 1)
+					throw std::invalid_argument("Invalid number of slices: '" + (std::string)argv[i] + "'");
+
+				_slices = n;
+			}
+			else if (!strcmp("--unsorted", argv[i]) || !strcmp("-u", argv[i]))
+			{
+				_unsorted = true;
+			}
+			else if (!strcmp("--summary-only", argv[i]))
+			{
+				_summary_only = true;
+			}
+			else if (!strcmp("--no-functions", argv[i]))
+			{
+				_functions = false;
+			}
+			else if (!strcmp("--no-messages", argv[i]))
+			{
+				_messages = false;
+			}
+			else if (!strcmp("--no-collectives", argv[i]))
+			{
+				_collectives = false;
+			}
+			else if (!strcmp("--no-plots", argv[i]))
+			{
+				_plots = false;
+			}
+			else if (!strcmp("--cache", argv[i]) || !strcmp("-c", argv[i]))
+			{
+				_cache = true;
+			}
+			else if (!strcmp("--pipeline", argv[i]))
+			{
+				_pipeline = true;
+			}
+			else if (!strcmp("--iahist-bins", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing number of bins for '" + (std::string)argv[i] + "'");
+
+				const int n = std::atoi(argv[++i]);
+				if (n < 1)
+					throw std::invalid_argument("Invalid number of bins: '" + (std::string)argv[i] + "'");
+
+				_iahist_bins = n;
+			}
+			else if (!strcmp("--iahist-max", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing upper end for '" + (std::string)argv[i] + "'");
+
+				const double max = std::atof(argv[++i]);
+				if (max <= 0.001)
+					throw std::invalid_argument("Invalid upper end of the histogram: '" + (std::string)argv[i] + "'");
+
+				_iahist_max = max;
+			}
+			else if (!strcmp("--iahist-log", argv[i]))
+			{
+				_iahist_log = true;
+			}
+			else if (!strcmp("--iahist-raw", argv[i]))
+			{
+				_iahist_raw = true;
+			}
+			else if (!strcmp("--inj-bins", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing number of bins for '" + (std::string)argv[i] + "'");
+
+				const int n = std::atoi(argv[++i]);
+				if (n < 1)
+					throw std::invalid_argument("Invalid number of bins: '" + (std::string)argv[i] + "'");
+
+				_inj_bins = n;
+			}
+			else if (!strcmp("--exact-sizes", argv[i]))
+			{
+				_exact_sizes = true;
+			}
+			else if (!strcmp("--ctr-bins", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing number of bins for '" + (std::string)argv[i] + "'");
+
+				const int n = std::atoi(argv[++i]);
+				if (n < 0)
+					throw std::invalid_argument("Invalid number of bins: '" + (std::string)argv[i] + "'");
+
+				_ctr_bins = n;
+			}
+			else if (!strcmp("--cct", argv[i]))
+			{
+				_cct = true;
+			}
+			else if (!strcmp("--comm-matrix", argv[i]))
+			{
+				_comm_matrix = true;
+			}
+			else if (!strcmp("--wait-states", argv[i]))
+			{
+				_wait_states = true;
+			}
+			else if (!strcmp("--call-sites", argv[i]))
+			{
+				if (i+1 >= argc-1)
+					throw std::invalid_argument("Missing number of call sites for '" + (std::string)argv[i] + "'");
+
+				const int n = std::atoi(argv[++i]);
+				if (n < 0)
+					throw std::invalid_argument("Invalid number of call sites: '" + (std::string)argv[i] + "'");
+
+				_call_sites = n;
+			}
+			else if (!strcmp("--rma", argv[i]))
+			{
+				_rma = true;
+			}
+			else if (!strcmp("--file-io", argv[i]))
+			{
+				_file_io = true;
+			}
 			else
 			{
 				throw std::invalid_argument("Unknow argument: '" + (std::string)argv[i] + "'");
@@ -97,6 +261,12 @@ Config::Config(const int argc, const char* argv[])
 		}
 	}
 
+	// the call trees and the wait states build on the call stacks of the function statistics
+	if (_cct && !_functions)
+		throw std::invalid_argument("--cct needs the function statistics, remove --no-functions");
+	if (_wait_states && !(_functions && _messages))
+		throw std::invalid_argument("--wait-states needs the function and message statistics, remove --no-functions/--no-messages");
+
 	// the last argument must be the OTF file
 	_otffile = argv[argc-1];
 	#ifdef DEBUG
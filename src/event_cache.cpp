@@ -0,0 +1,410 @@
+#include <event_cache.h>
+
+const uint32_t EventCache::version;
+const uint64_t EventCache::block_size;
+
+static const char cache_magic[8] = {'S','O','N','A','R','E','V','C'};
+
+static inline size_t padded(size_t bytes)
+{
+	/* columns start at 8 byte boundaries */
+	return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+static std::string sourceStamp(const std::string &otffile)
+{
+	/* identifies the version of the trace the cache was built from: name, size
+	 * and modification time of every file of the trace (master control,
+	 * definitions, event streams, ...) */
+
+	const size_t slash = otffile.rfind('/');
+	const std::string dir = slash != std::string::npos ? otffile.substr(0, slash + 1) : "./";
+	std::string stub = otffile.substr(slash != std::string::npos ? slash + 1 : 0);
+	if (stub.size() > 4 && stub.substr(stub.size()-4) == ".otf")
+		stub.resize(stub.size()-4);
+	stub += ".";
+
+	struct stat st;
+	if (stat(otffile.c_str(), &st))
+		return "";
+
+	DIR *d = opendir(dir.c_str());
+	if (d == nullptr)
+		return "";
+
+	// sorted, readdir returns the files in any order
+	std::set<std::string> files;
+	for (struct dirent *e = readdir(d); e != nullptr; e = readdir(d))
+	{
+		const std::string name = e->d_name;
+		if (name.compare(0, stub.size(), stub) == 0 && name.find(".sonar-cache") == std::string::npos)
+			files.insert(name);
+	}
+	closedir(d);
+
+	std::stringstream stamp;
+	for (const auto &f:files)
+		if (!stat((dir + f).c_str(), &st))
+			stamp << f << " " << st.st_size << " " << st.st_mtime << " ";
+	return stamp.str();
+}
+
+EventCache::Mapping::Mapping(const std::string &filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Can not open event cache file " + filename + " (" + strerror(errno) + ")");
+
+	struct stat st;
+	if (fstat(fd, &st))
+	{
+		::close(fd);
+		throw std::runtime_error("Can not stat event cache file " + filename + " (" + strerror(errno) + ")");
+	}
+	size = st.st_size;
+
+	if (size > 0)
+		addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (size < sizeof(cache_magic) + 8 || addr == MAP_FAILED || memcmp(addr, cache_magic, sizeof(cache_magic)))
+	{
+		if (addr != MAP_FAILED)
+			munmap(addr, size);
+		addr = MAP_FAILED;
+		throw std::runtime_error("Invalid event cache file " + filename);
+	}
+	madvise(addr, size, MADV_SEQUENTIAL);
+
+	// header: magic, version, process
+	const uint8_t *base = static_cast<const uint8_t*>(addr);
+	memcpy(&_process, base + sizeof(cache_magic) + 4, 4);
+	size_t pos = sizeof(cache_magic) + 8;
+
+	while (pos + 8 <= size)
+	{
+		Columns col;
+		memcpy(&col.n, base+pos, 8);
+		pos += 8;
+
+		const size_t n = col.n;
+		const size_t need = padded(n) + 4*padded(4*n) + 4*8*n;
+		if (n == 0 || need > size - pos)
+			break;
+
+		col.kind = base+pos;                                      pos += padded(n);
+		col.time = reinterpret_cast<const uint64_t*>(base+pos);   pos += 8*n;
+		col.a    = reinterpret_cast<const uint32_t*>(base+pos);   pos += padded(4*n);
+		col.b    = reinterpret_cast<const uint32_t*>(base+pos);   pos += padded(4*n);
+		col.c    = reinterpret_cast<const uint32_t*>(base+pos);   pos += padded(4*n);
+		col.s    = reinterpret_cast<const uint32_t*>(base+pos);   pos += padded(4*n);
+		col.v    = reinterpret_cast<const uint64_t*>(base+pos);   pos += 8*n;
+		col.w    = reinterpret_cast<const uint64_t*>(base+pos);   pos += 8*n;
+		col.m    = reinterpret_cast<const uint64_t*>(base+pos);   pos += 8*n;
+
+		_blocks.push_back(col);
+	}
+
+	if (pos != size)
+	{
+		munmap(addr, size);
+		addr = MAP_FAILED;
+		throw std::runtime_error("Truncated event cache file " + filename);
+	}
+}
+
+EventCache::Mapping::~Mapping()
+{
+	if (addr != MAP_FAILED)
+		munmap(addr, size);
+}
+
+EventCache::EventCache(const std::string &dir) :
+	dirname(dir)
+{
+#ifdef DEBUG
+	ctor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+EventCache::~EventCache()
+{
+#ifdef DEBUG
+	dtor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+inline void EventCache::add(uint32_t proc, EventKind kind, uint64_t time, uint32_t a, uint32_t b, uint32_t c, uint32_t s, uint64_t v, uint64_t w, uint64_t m)
+{
+	auto &block = pending[proc];
+
+	block.kind.push_back(kind);
+	block.time.push_back(time);
+	block.a.push_back(a);
+	block.b.push_back(b);
+	block.c.push_back(c);
+	block.s.push_back(s);
+	block.v.push_back(v);
+	block.w.push_back(w);
+	block.m.push_back(m);
+
+	if (block.kind.size() >= block_size)
+		flush(proc, block);
+}
+
+void EventCache::flush(uint32_t proc, Block &block)
+{
+	const uint64_t n = block.kind.size();
+	if (n == 0 || failed)
+		return;
+
+	const std::string fname = filename(dirname, proc);
+	std::ofstream out(fname, std::ofstream::out | std::ofstream::binary | std::ofstream::app);
+
+	// new file: write the header
+	if (block.total == 0)
+	{
+		out.write(cache_magic, sizeof(cache_magic));
+		out.write(reinterpret_cast<const char*>(&version), 4);
+		out.write(reinterpret_cast<const char*>(&proc), 4);
+	}
+
+	const char zeros[8] = {0};
+	const auto _column = [&](const void *data, size_t bytes)
+	{
+		out.write(static_cast<const char*>(data), bytes);
+		out.write(zeros, padded(bytes) - bytes);
+	};
+
+	out.write(reinterpret_cast<const char*>(&n), 8);
+	_column(block.kind.data(), n);
+	_column(block.time.data(), 8*n);
+	_column(block.a.data(), 4*n);
+	_column(block.b.data(), 4*n);
+	_column(block.c.data(), 4*n);
+	_column(block.s.data(), 4*n);
+	_column(block.v.data(), 8*n);
+	_column(block.w.data(), 8*n);
+	_column(block.m.data(), 8*n);
+	out.close();
+
+	if (!out)
+	{
+		std::cout << "Warning: can not write event cache file " << fname << ", caching disabled" << std::endl;
+		failed = true;
+	}
+
+	block.total += n;
+	block.kind.clear();
+	block.time.clear();
+	block.a.clear();
+	block.b.clear();
+	block.c.clear();
+	block.s.clear();
+	block.v.clear();
+	block.w.clear();
+	block.m.clear();
+}
+
+void EventCache::addEnter(uint32_t proc, uint64_t time, uint32_t func, uint32_t source)
+{
+	add(proc, ENTER, time, func, 0, 0, source, 0, 0, 0);
+}
+
+void EventCache::addLeave(uint32_t proc, uint64_t time, uint32_t func, uint32_t source)
+{
+	add(proc, LEAVE, time, func, 0, 0, source, 0, 0, 0);
+}
+
+void EventCache::addSend(uint32_t proc, uint64_t time, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+{
+	add(proc, SEND, time, receiver, group, type, source, length, 0, 0);
+}
+
+void EventCache::addRecv(uint32_t proc, uint64_t time, uint32_t sender, uint32_t group, uint32_t type, uint32_t length, uint32_t source)
+{
+	add(proc, RECV, time, sender, group, type, source, length, 0, 0);
+}
+
+void EventCache::addCounter(uint32_t proc, uint64_t time, uint32_t counter, uint64_t value)
+{
+	add(proc, COUNTER, time, counter, 0, 0, 0, value, 0, 0);
+}
+
+void EventCache::addBeginCollop(uint32_t proc, uint64_t time, uint32_t op, uint64_t matchingId, uint32_t group, uint32_t root, uint64_t sent, uint64_t recv, uint32_t source)
+{
+	add(proc, BEGIN_COLLOP, time, op, group, root, source, sent, recv, matchingId);
+}
+
+void EventCache::addEndCollop(uint32_t proc, uint64_t time, uint64_t matchingId)
+{
+	add(proc, END_COLLOP, time, 0, 0, 0, 0, 0, 0, matchingId);
+}
+
+void EventCache::addRmaPut(uint32_t proc, uint64_t time, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+{
+	add(proc, RMA_PUT, time, origin, target, comm, source, bytes, tag, 0);
+}
+
+void EventCache::addRmaPutRemoteEnd(uint32_t proc, uint64_t time, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+{
+	add(proc, RMA_PUT_RE, time, origin, target, comm, source, bytes, tag, 0);
+}
+
+void EventCache::addRmaGet(uint32_t proc, uint64_t time, uint32_t origin, uint32_t target, uint32_t comm, uint32_t tag, uint64_t bytes, uint32_t source)
+{
+	add(proc, RMA_GET, time, origin, target, comm, source, bytes, tag, 0);
+}
+
+void EventCache::addRmaEnd(uint32_t proc, uint64_t time, uint32_t remote, uint32_t comm, uint32_t tag, uint32_t source)
+{
+	add(proc, RMA_END, time, remote, 0, comm, source, 0, tag, 0);
+}
+
+void EventCache::addFileOp(uint32_t proc, uint64_t time, uint32_t file, uint64_t handle, uint32_t op, uint64_t bytes, uint64_t duration, uint32_t source)
+{
+	add(proc, FILEOP, time, file, 0, op, source, bytes, handle, duration);
+}
+
+void EventCache::addBeginFileOp(uint32_t proc, uint64_t time, uint64_t matchingId, uint32_t source)
+{
+	add(proc, BEGIN_FILEOP, time, 0, 0, 0, source, 0, 0, matchingId);
+}
+
+void EventCache::addEndFileOp(uint32_t proc, uint64_t time, uint32_t file, uint64_t matchingId, uint64_t handle, uint32_t op, uint64_t bytes, uint32_t source)
+{
+	add(proc, END_FILEOP, time, file, 0, op, source, bytes, handle, matchingId);
+}
+
+std::map<uint32_t, uint64_t> EventCache::close(void)
+{
+	std::map<uint32_t, uint64_t> written;
+
+	for (auto &p:pending)
+	{
+		flush(p.first, p.second);
+		written[p.first] = p.second.total;
+	}
+	pending.clear();
+
+	return written;
+}
+
+std::string EventCache::location(const std::string &otffile)
+{
+	// trace.otf -> trace.sonar-cache
+	std::string stub = otffile;
+	if (stub.size() > 4 && stub.substr(stub.size()-4) == ".otf")
+		stub.resize(stub.size()-4);
+
+	return stub + ".sonar-cache";
+}
+
+std::string EventCache::filename(const std::string &dir, uint32_t proc)
+{
+	return dir + "/p" + std::to_string(proc) + ".col";
+}
+
+bool EventCache::isValid(const std::string &dir, const std::string &otffile)
+{
+	std::ifstream index(dir + "/index");
+	if (!index)
+		return false;
+
+	std::string magic, stamp;
+	uint32_t v = 0;
+	index >> magic >> v;
+	index.ignore();
+	std::getline(index, stamp);
+
+	return magic == "sonar-event-cache" && v == version && !stamp.empty() && stamp == sourceStamp(otffile);
+}
+
+std::vector<uint32_t> EventCache::processes(const std::string &dir)
+{
+	std::ifstream index(dir + "/index");
+
+	std::string line;
+	std::getline(index, line); // magic, version
+	std::getline(index, line); // source stamp
+	std::getline(index, line); // events read
+
+	std::vector<uint32_t> procs;
+	uint32_t proc;
+	uint64_t events;
+	while (index >> proc >> events)
+		procs.push_back(proc);
+
+	return procs;
+}
+
+uint64_t EventCache::events(const std::string &dir)
+{
+	/* events read from the trace when the cache was built */
+
+	std::ifstream index(dir + "/index");
+
+	std::string line;
+	std::getline(index, line); // magic, version
+	std::getline(index, line); // source stamp
+
+	uint64_t n = 0;
+	index >> n;
+	return n;
+}
+
+bool EventCache::prepare(const std::string &dir)
+{
+	/* creates an empty directory for a new cache */
+
+	remove(dir);
+	if (mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH))
+	{
+		std::cout << "Warning: can not create event cache " << dir << " (" << strerror(errno) << ")" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool EventCache::commit(const std::string &tmpdir, const std::string &dir, const std::string &otffile, uint64_t events, const std::map<uint32_t, uint64_t> &procs)
+{
+	/* the index is written last and the directory renamed, so a cache is either complete or absent */
+
+	std::ofstream index(tmpdir + "/index");
+	index << "sonar-event-cache " << version << '\n';
+	index << sourceStamp(otffile) << '\n';
+	index << events << '\n';
+	for (const auto &p:procs)
+		index << p.first << " " << p.second << '\n';
+	index.close();
+
+	remove(dir);
+	if (!index || rename(tmpdir.c_str(), dir.c_str()))
+	{
+		std::cout << "Warning: can not store event cache " << dir << " (" << strerror(errno) << ")" << std::endl;
+		remove(tmpdir);
+		return false;
+	}
+
+	return true;
+}
+
+void EventCache::remove(const std::string &dir)
+{
+	/* deletes a cache directory and the files in it */
+
+	DIR *d = opendir(dir.c_str());
+	if (d == nullptr)
+		return;
+
+	while (struct dirent *entry = readdir(d))
+	{
+		const std::string name = entry->d_name;
+		if (name != "." && name != "..")
+			unlink((dir + "/" + name).c_str());
+	}
+	closedir(d);
+
+	rmdir(dir.c_str());
+}
@@ -0,0 +1,65 @@
+#include <file_op_tracker.h>
+
+FileOpTracker::FileOpTracker()
+{
+#ifdef DEBUG
+	ctor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+FileOpTracker::~FileOpTracker()
+{
+#ifdef DEBUG
+	dtor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+void FileOpTracker::subscribe(Subscriber s)
+{
+	subscribers.push_back(s);
+}
+
+bool FileOpTracker::complete(uint64_t id, Operation op)
+{
+	const Key k {op.proc, id};
+	const uint64_t *begin = begins.get(k);
+	if (begin == nullptr)
+		return false;
+
+	op.begin = *begin;
+	begins.erase(k);
+
+	for (const auto &f:subscribers)
+		f(op);
+	return true;
+}
+
+void FileOpTracker::addBegin(uint32_t proc, uint64_t time, uint64_t id)
+{
+	// a matching id in use again starts over
+	begins[{proc, id}] = time;
+}
+
+void FileOpTracker::addEnd(uint32_t proc, uint64_t time, uint64_t id, uint32_t file, uint32_t op, uint64_t bytes)
+{
+	const Operation o {proc, file, op, bytes, time, time};
+	if (!complete(id, o))
+		open_ends.push_back({id, o});
+}
+
+void FileOpTracker::addOperation(uint32_t proc, uint64_t begin, uint64_t end, uint32_t file, uint32_t op, uint64_t bytes)
+{
+	const Operation o {proc, file, op, bytes, begin, end};
+	for (const auto &f:subscribers)
+		f(o);
+}
+
+void FileOpTracker::merge(const FileOpTracker &other)
+{
+	// operations ended in other but begun here
+	for (const auto &e:other.open_ends)
+		if (!complete(e.id, e.op))
+			open_ends.push_back(e);
+
+	other.begins.forEach([this](const Key &k, uint64_t begin) { begins[k] = begin; });
+}
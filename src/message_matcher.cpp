@@ -0,0 +1,143 @@
+#include <message_matcher.h>
+
+MessageMatcher::MessageMatcher(bool shard) :
+	is_shard(shard)
+{
+#ifdef DEBUG
+	ctor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+MessageMatcher::~MessageMatcher()
+{
+#ifdef DEBUG
+	dtor_msg(__PRETTY_FUNCTION__);
+#endif
+}
+
+void MessageMatcher::subscribe(Subscriber s)
+{
+	subscribers.push_back(s);
+}
+
+void MessageMatcher::own(uint32_t proc)
+{
+	owned[proc] = true;
+}
+
+uint64_t MessageMatcher::KeyHash::operator()(const Key &k) const
+{
+	// both halves of the key
+	const uint64_t h = (static_cast<uint64_t>(k.sender) << 32 | k.receiver) * 0x9e3779b97f4a7c15ULL;
+	return mix64(h ^ (static_cast<uint64_t>(k.comm) << 32 | k.tag));
+}
+
+void MessageMatcher::push(Queue &q, uint64_t time, uint64_t length, uint64_t region)
+{
+	uint32_t n = free_nodes;
+	if (n != none)
+	{
+		free_nodes = pool[n].next;
+		pool[n] = {time, length, region, none};
+	}
+	else
+	{
+		if (pool.size() == none)
+			throw std::bad_alloc();
+		n = pool.size();
+		pool.push_back({time, length, region, none});
+	}
+
+	if (q.empty())
+		q.head = n;
+	else
+		pool[q.tail].next = n;
+	q.tail = n;
+}
+
+MessageMatcher::Pending MessageMatcher::pop(Queue &q)
+{
+	const uint32_t n = q.head;
+	const Pending p = pool[n];
+
+	q.head = p.next;
+	if (q.empty())
+		q.tail = none;
+
+	pool[n].next = free_nodes;
+	free_nodes = n;
+	return p;
+}
+
+void MessageMatcher::match(const Key &k, Channel &c)
+{
+	while (!c.send.empty() && !c.recv.empty())
+	{
+		const Pending snd = pop(c.send);
+		const Pending rcv = pop(c.recv);
+		pending_sends--;
+		pending_recvs--;
+
+		// the receive tells the size that arrived
+		const Match m {k.sender, k.receiver, snd.time, rcv.time, rcv.length, snd.region, rcv.region};
+		for (const auto &f:subscribers)
+			f(m);
+	}
+}
+
+bool MessageMatcher::matches(const Key &k, Channel &c)
+{
+	// a channel stays local once both of its ends are owned
+	if (!is_shard || c.local)
+		return true;
+
+	c.local = owned.get(k.sender) != nullptr && owned.get(k.receiver) != nullptr;
+	return c.local;
+}
+
+void MessageMatcher::addSend(uint64_t time, uint32_t sender, uint32_t receiver, uint32_t comm, uint32_t tag, uint64_t length, uint64_t region)
+{
+	const Key k {sender, receiver, comm, tag};
+	Channel &c = channels[k];
+	push(c.send, time, length, region);
+	pending_sends++;
+
+	if (matches(k, c))
+		match(k, c);
+}
+
+void MessageMatcher::addRecv(uint64_t time, uint32_t receiver, uint32_t sender, uint32_t comm, uint32_t tag, uint64_t length, uint64_t region)
+{
+	const Key k {sender, receiver, comm, tag};
+	Channel &c = channels[k];
+	push(c.recv, time, length, region);
+	pending_recvs++;
+
+	if (matches(k, c))
+		match(k, c);
+}
+
+void MessageMatcher::merge(const MessageMatcher &other)
+{
+	// the messages of other queue up behind ours
+	other.channels.forEach([this, &other](const Key &k, const Channel &o)
+	{
+		if (o.send.empty() && o.recv.empty())
+			return;
+
+		Channel &c = channels[k];
+		for (uint32_t n=o.send.head; n != none; n=other.pool[n].next)
+		{
+			push(c.send, other.pool[n].time, other.pool[n].length, other.pool[n].region);
+			pending_sends++;
+		}
+		for (uint32_t n=o.recv.head; n != none; n=other.pool[n].next)
+		{
+			push(c.recv, other.pool[n].time, other.pool[n].length, other.pool[n].region);
+			pending_recvs++;
+		}
+
+		if (!is_shard)
+			match(k, c);
+	});
+}
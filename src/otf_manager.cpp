@@ -12,6 +12,9 @@ OTF_Manager::OTF_Manager(std::shared_ptr<Config> _cfg, uint32_t nfiles, uint32_t
 	ctor_msg(__PRETTY_FUNCTION__);
 #endif
 
+	num_files   = nfiles;
+	buffer_size = buffersize;
+
 	// init custom data structures
 	udata.cfg = _cfg;
 	if (udata.cfg == nullptr)
@@ -21,6 +24,11 @@ OTF_Manager::OTF_Manager(std::shared_ptr<Config> _cfg, uint32_t nfiles, uint32_t
 
 	udata.ts = std::make_shared<TraceStats>(udata.cfg);
 	udata.tviz = std::make_shared<TraceVisualizer>(udata.cfg, udata.ts);
+	udata.batches = TokenMap<MessageBatch>(udata.ts->getProcessIndex());
+	track_activity(udata, false);
+	match_messages(udata, false);
+	track_collectives(udata);
+	track_file_ops(udata);
 
 	// init data structures of OTF library
 	manager = OTF_FileManager_open(nfiles);
@@ -44,9 +52,9 @@ OTF_Manager::OTF_Manager(std::shared_ptr<Config> _cfg, uint32_t nfiles, uint32_t
 		throw std::bad_alloc();
 	}
 
-	// the template parameter determines the implementation
+	// the enabled analyses determine the implementation
 	// of the handlers to be used
-	set_handler_Functions<Sonar<UserData>>();
+	use_handlers(sonar_features(*udata.cfg));
 
 	OTF_Reader_setBufferSizes(reader, buffersize);
 	OTF_Reader_setTimeInterval(reader, 0, std::numeric_limits<uint64_t>::max());
@@ -72,6 +80,12 @@ OTF_Manager::~OTF_Manager()
 	OTF_FileManager_close(manager);
 
 	// print stats on exit
+	udata.ts->setUnmatchedMessages(udata.matcher->pendingSends(), udata.matcher->pendingRecvs());
+	udata.colls->finish();
+	udata.ts->setUnfinishedCollectives(udata.colls->unfinishedInstances(), udata.colls->unmatchedEnds());
+	udata.ts->setUnmatchedFileOps(udata.files->pendingBegins(), udata.files->unmatchedEnds());
+	if (udata.cfg->rma)
+		udata.ts->applyRma();
 	udata.ts->print();
 
 #ifdef DEBUG
@@ -100,11 +114,72 @@ void OTF_Manager::read_otf(void)
 		throw std::runtime_error(otf_read_error_msg);
 	}
 
-	read = OTF_Reader_readEvents(reader, handler_array);
-	std::cout << "Read " << read << " events" << std::endl;
-	if (read == OTF_READ_ERROR)
+	if (udata.cfg->summary_only)
 	{
-		throw std::runtime_error(otf_read_error_msg);
+		std::cout << "Skipped events (summary-only mode)" << std::endl;
+	}
+	else
+	{
+		// the stream-wise readers skip the merge of all streams by time,
+		// use them unless an enabled analysis relies on the global order
+		const bool ordered = events_need_order();
+		const bool sliced  = !ordered && udata.cfg->slices > 1 && udata.ts->getOtfParam().time_end > 0 && !slices_split_analysis();
+
+		// the event cache holds the events per process, so it can only
+		// replace the stream-wise readers
+		const bool        use_cache = !ordered && udata.cfg->cache;
+		const std::string cachedir  = EventCache::location(udata.cfg->otffile);
+		const std::string tmpdir    = cachedir + ".tmp";
+
+		if (use_cache && EventCache::isValid(cachedir, udata.cfg->otffile))
+		{
+			read = read_events_cached(cachedir);
+		}
+		else
+		{
+			// slices split the events of a process, they are not cached
+			if (use_cache && sliced)
+				std::cout << "Warning: the event cache is not written when reading in time slices" << std::endl;
+			else if (use_cache && EventCache::prepare(tmpdir))
+			{
+				udata.cache = std::make_shared<EventCache>(tmpdir);
+				use_handlers(sonar_features(*udata.cfg) | SONAR_CACHE);
+			}
+
+			// the parallel readers analyse on their reading threads
+			const bool parallel = !ordered && udata.cfg->threads > 1;
+			if (udata.cfg->pipeline && (sliced || parallel))
+				std::cout << "Warning: --pipeline is ignored when reading with several threads or in time slices" << std::endl;
+
+			if (sliced)
+				read = read_events_sliced();
+			else if (parallel)
+				read = read_events_parallel();
+			else if (udata.cfg->pipeline && !udata.cfg->rawotf)
+				read = read_events_pipelined(!ordered && (udata.cfg->unsorted || udata.cache));
+			else if (!ordered && (udata.cfg->unsorted || udata.cache))
+				read = OTF_Reader_readEventsUnsorted(reader, handler_array);
+			else
+				read = OTF_Reader_readEvents(reader, handler_array);
+
+			if (udata.cache)
+			{
+				close_cache(udata);
+				udata.cache.reset();
+				use_handlers(sonar_features(*udata.cfg));
+
+				if (read != OTF_READ_ERROR && cache_ok && EventCache::commit(tmpdir, cachedir, udata.cfg->otffile, read, cached_procs))
+					std::cout << "Stored event cache " << cachedir << std::endl;
+				else
+					EventCache::remove(tmpdir);
+			}
+		}
+		sonar->flush(&udata);
+		std::cout << "Read " << read << " events" << std::endl;
+		if (read == OTF_READ_ERROR)
+		{
+			throw std::runtime_error(otf_read_error_msg);
+		}
 	}
 
 	read = OTF_Reader_readStatistics(reader, handler_array);
@@ -114,11 +189,19 @@ void OTF_Manager::read_otf(void)
 		throw std::runtime_error(otf_read_error_msg);
 	}
 
-	read = OTF_Reader_readSnapshots(reader, handler_array);
-	std::cout << "Read " << read << " snapshots" << std::endl;
-	if (read == OTF_READ_ERROR)
+	if (udata.cfg->summary_only)
 	{
-		throw std::runtime_error(otf_read_error_msg);
+		udata.ts->applySummaries();
+		std::cout << "Skipped snapshots (summary-only mode)" << std::endl;
+	}
+	else
+	{
+		read = OTF_Reader_readSnapshots(reader, handler_array);
+		std::cout << "Read " << read << " snapshots" << std::endl;
+		if (read == OTF_READ_ERROR)
+		{
+			throw std::runtime_error(otf_read_error_msg);
+		}
 	}
 
 	read = OTF_Reader_readMarkers(reader, handler_array);
@@ -129,8 +212,992 @@ void OTF_Manager::read_otf(void)
 	}
 }
 
+bool OTF_Manager::events_need_order(void)
+{
+	/* true if any enabled analysis requires the events in global time order */
+
+	bool ordered = false;
+
+	// raw output is only readable in time order (and not interleaved by threads)
+	if (udata.cfg->rawotf)
+		ordered = true;
+
+	if (udata.ts->needsTimeOrder() || udata.tviz->needsTimeOrder())
+		ordered = true;
+
+	if (ordered && (udata.cfg->threads > 1 || udata.cfg->slices > 1 || udata.cfg->unsorted) && udata.cfg->verbose)
+		std::cout << "Events are required in time order, falling back to sorted reading" << std::endl;
+
+	return ordered;
+}
+
+bool OTF_Manager::slices_split_analysis(void)
+{
+	/* true if an enabled analysis needs the events of a process in one part */
+
+	const bool whole = udata.ts->needsWholeProcesses();
+	if (whole && udata.cfg->slices > 1 && udata.cfg->verbose)
+		std::cout << "Events of a process are required in one piece, reading without time slices" << std::endl;
+
+	return whole;
+}
+
+static void run_parallel(size_t ntasks, uint32_t nthreads, const std::function<void(uint32_t, size_t)> &task)
+{
+	/*
+	 * Runs task(worker, i) for i = 0..ntasks-1 on a pool of nthreads workers.
+	 * The first exception thrown by a task is re-thrown after all workers finished.
+	 */
+
+	std::atomic<size_t> next {0};
+	std::atomic<bool>   failed {false};
+	std::vector<std::exception_ptr> errors(nthreads);
+
+	auto worker = [&](uint32_t id)
+	{
+		try
+		{
+			for (size_t i=next++; i<ntasks && !failed; i=next++)
+				task(id, i);
+		}
+		catch (...)
+		{
+			errors[id] = std::current_exception();
+			failed = true;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (uint32_t id=0; id<nthreads; id++)
+		workers.emplace_back(worker, id);
+	for (auto &w:workers)
+		w.join();
+
+	for (auto &e:errors)
+		if (e)
+			std::rethrow_exception(e);
+}
+
+uint64_t OTF_Manager::read_events_parallel(void)
+{
+	/*
+	 * Reads the event streams of the trace with a pool of worker threads.
+	 * Every worker accumulates into its own TraceStats/TraceVisualizer shard,
+	 * the shards are merged into udata afterwards. A process is always
+	 * recorded in exactly one stream, so the per-process data of the shards
+	 * is disjoint and the merged result equals the one of a serial run.
+	 */
+
+	std::vector<uint32_t> streams;
+	std::vector<std::vector<uint32_t>> stream_procs;
+	OTF_MasterControl *mc = OTF_Reader_getMasterControl(reader);
+	for (uint32_t i=0; i<OTF_MasterControl_getCount(mc); i++)
+	{
+		const OTF_MapEntry *entry = OTF_MasterControl_getEntryByIndex(mc, i);
+		streams.push_back(entry->argument);
+		stream_procs.emplace_back(entry->values, entry->values + entry->n);
+	}
+
+	const uint32_t nworkers = std::max<uint32_t>(1, std::min<uint32_t>(udata.cfg->threads, streams.size()));
+	if (udata.cfg->verbose)
+		std::cout << "Reading " << streams.size() << " streams with " << nworkers << " threads" << std::endl;
+
+	std::vector<UserData> shards = make_shards(nworkers);
+
+	char *namestub = OTF_stripFilename(udata.cfg->otffile.c_str());
+	if (namestub == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	// one file manager and handler array per worker, reused for all of its streams
+	std::vector<OTF_FileManager*>  managers(nworkers, nullptr);
+	std::vector<OTF_HandlerArray*> handlers(nworkers, nullptr);
+	for (uint32_t w=0; w<nworkers; w++)
+	{
+		managers[w] = OTF_FileManager_open(num_files);
+		handlers[w] = OTF_HandlerArray_open();
+		if (handlers[w] != nullptr)
+			sonar->set(handlers[w], &shards[w]);
+	}
+
+	auto close_workers = [&]()
+	{
+		free(namestub);
+		for (uint32_t w=0; w<nworkers; w++)
+		{
+			if (handlers[w] != nullptr)
+				OTF_HandlerArray_close(handlers[w]);
+			if (managers[w] != nullptr)
+				OTF_FileManager_close(managers[w]);
+		}
+	};
+
+	std::atomic<uint64_t> events     {0};
+	std::atomic<bool>     read_error {false};
+
+	auto read_stream = [&](uint32_t worker, size_t i)
+	{
+		OTF_RStream *rstream = nullptr;
+		if (managers[worker] != nullptr && handlers[worker] != nullptr)
+			rstream = OTF_RStream_open(namestub, streams[i], managers[worker]);
+
+		if (rstream == nullptr)
+		{
+			read_error = true;
+			return;
+		}
+
+		OTF_RStream_setBufferSizes(rstream, buffer_size);
+		for (const auto &p:stream_procs[i])
+			shards[worker].matcher->own(p);
+		shards[worker].colls->own(shards[worker].ts->getMembersAmong(stream_procs[i]));
+
+		uint64_t read = OTF_RStream_readEvents(rstream, handlers[worker]);
+		if (read == OTF_READ_ERROR)
+			read_error = true;
+		else
+			events += read;
+
+		OTF_RStream_close(rstream);
+	};
+
+	try
+	{
+		run_parallel(streams.size(), nworkers, read_stream);
+	}
+	catch (...)
+	{
+		close_workers();
+		throw;
+	}
+	close_workers();
+
+	if (read_error)
+		return OTF_READ_ERROR;
+
+	// merge in a fixed order to keep the output deterministic
+	for (auto &shard:shards)
+	{
+		sonar->flush(&shard);
+		udata.activity->merge(*shard.activity);
+		udata.ts->merge(*shard.ts);
+		udata.matcher->merge(*shard.matcher);
+		udata.colls->merge(*shard.colls);
+		udata.files->merge(*shard.files);
+		udata.tviz->merge(*shard.tviz);
+		if (shard.cache)
+			close_cache(shard);
+	}
+
+	return events;
+}
+
+template<typename T, typename D>
+static uint64_t replay_events(const std::string &filename, D *data)
+{
+	/* feeds the events of one cached process to the handlers of T */
+
+	EventCache::Mapping map(filename);
+	const uint32_t proc = map.process;
+
+	uint64_t events = 0;
+	for (const auto &col:map.blocks)
+	{
+		for (uint64_t i=0; i<col.n; i++)
+			dispatch_event<T>(data, col.kind[i], col.time[i], proc, col.a[i], col.b[i], col.c[i], col.s[i], col.v[i], col.w[i], col.m[i]);
+		events += col.n;
+	}
+
+	return events;
+}
+
+uint64_t OTF_Manager::read_events_cached(const std::string &dir)
+{
+	/*
+	 * Replays the events from the memory-mapped cache files instead of
+	 * decompressing and parsing the trace. Every file holds one process,
+	 * with several threads the processes are spread over shards like the
+	 * streams in read_events_parallel(). Returns the events read from the
+	 * trace when the cache was built, like a direct read would.
+	 */
+
+	const std::vector<uint32_t> procs = EventCache::processes(dir);
+	const uint32_t nworkers = std::max<uint32_t>(1, std::min<uint32_t>(udata.cfg->threads, procs.size()));
+	if (udata.cfg->verbose)
+		std::cout << "Reading " << procs.size() << " processes from event cache " << dir << " with " << nworkers << " threads" << std::endl;
+
+	std::atomic<uint64_t> events {0};
+
+	if (nworkers == 1)
+	{
+		for (const auto &p:procs)
+			events += sonar->replay(EventCache::filename(dir, p), &udata);
+	}
+	else
+	{
+		std::vector<UserData> shards = make_shards(nworkers);
+
+		run_parallel(procs.size(), nworkers, [&](uint32_t worker, size_t i)
+		{
+			shards[worker].matcher->own(procs[i]);
+			shards[worker].colls->own(shards[worker].ts->getMembersAmong({procs[i]}));
+			events += sonar->replay(EventCache::filename(dir, procs[i]), &shards[worker]);
+		});
+
+		for (auto &shard:shards)
+		{
+			sonar->flush(&shard);
+			udata.activity->merge(*shard.activity);
+			udata.ts->merge(*shard.ts);
+			udata.matcher->merge(*shard.matcher);
+			udata.colls->merge(*shard.colls);
+			udata.files->merge(*shard.files);
+			udata.tviz->merge(*shard.tviz);
+		}
+	}
+
+	// the cache leaves out the records no analysis uses
+	if (udata.cfg->verbose)
+		std::cout << "Replayed " << events << " cached events" << std::endl;
+
+	return EventCache::events(dir);
+}
+
+/*
+ * Reader side of the pipelined event reading: the handlers only decode the
+ * records into batches of EventRecords. Full batches are passed to the
+ * analysis thread through one ring buffer and come back empty through a
+ * second one, so no memory is allocated while reading. A side finding its
+ * ring empty spins briefly and then sleeps until the other side moved a
+ * batch, so a stalled stage does not hold a core.
+ */
+struct EventPipeline {
+	static const size_t batch_size  {4096};
+	static const size_t num_batches {16};
+	static const int    spins       {64};
+
+	struct Batch {
+		size_t      n {0};
+		EventRecord events[batch_size];
+	};
+
+	/*
+	 * Only the num_batches batches of the pool circulate, each one is in at
+	 * most one ring at a time. With room for all of them (and the end
+	 * marker) a push cannot fail.
+	 */
+	std::vector<Batch> pool;
+	SpscRing<Batch*>   full  {num_batches+1}; // +1 for the end marker
+	SpscRing<Batch*>   empty {num_batches};
+	Batch             *current {nullptr};
+	std::atomic<bool>  abort {false};
+
+	std::mutex              lock;
+	std::condition_variable moved;
+
+	EventPipeline() :
+		pool(num_batches)
+	{
+		for (auto &b:pool)
+			put(empty, &b);
+	}
+
+	EventPipeline(const EventPipeline&) = delete;
+	EventPipeline& operator=(const EventPipeline&) = delete;
+
+	void put(SpscRing<Batch*> &ring, Batch *b)
+	{
+		const bool pushed = ring.push(b);
+		assert(pushed);
+		(void)pushed;
+
+		// taking the lock orders the push before a waiter's check
+		{
+			std::lock_guard<std::mutex> guard(lock);
+		}
+		moved.notify_all();
+	}
+
+	// false only if the pipeline was aborted
+	bool take(SpscRing<Batch*> &ring, Batch *&b)
+	{
+		for (int i=0; i<spins; i++)
+		{
+			if (ring.pop(b))
+				return true;
+			if (abort)
+				return false;
+			std::this_thread::yield();
+		}
+
+		std::unique_lock<std::mutex> guard(lock);
+		bool got = false;
+		moved.wait(guard, [&]() { return (got = ring.pop(b)) || abort; });
+		return got;
+	}
+
+	void stop(void)
+	{
+		abort = true;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+		}
+		moved.notify_all();
+	}
+
+	// slot for the next record, nullptr if the analysis thread stopped
+	EventRecord *next(void)
+	{
+		if (current != nullptr && current->n == batch_size)
+		{
+			put(full, current);
+			current = nullptr;
+		}
+
+		if (current == nullptr && !take(empty, current))
+			return nullptr;
+
+		return &current->events[current->n++];
+	}
+
+	// passes the last batch and the end marker to the analysis thread
+	void finish(void)
+	{
+		if (current != nullptr && current->n > 0)
+			put(full, current);
+		current = nullptr;
+
+		put(full, nullptr);
+	}
+
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+	static int handleEnter(void* userData, uint64_t time, uint32_t function, uint32_t process, uint32_t source, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = ENTER;
+		e->time = time;
+		e->proc = process;
+		e->a    = function;
+		e->s    = source;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleLeave(void* userData, uint64_t time, uint32_t function, uint32_t process, uint32_t source, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = LEAVE;
+		e->time = time;
+		e->proc = process;
+		e->a    = function;
+		e->s    = source;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleSendMsg(void* userData, uint64_t time, uint32_t sender, uint32_t receiver, uint32_t group, uint32_t type, uint32_t length, uint32_t source, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = SEND;
+		e->time = time;
+		e->proc = sender;
+		e->a    = receiver;
+		e->b    = group;
+		e->c    = type;
+		e->v    = length;
+		e->s    = source;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleRecvMsg(void* userData, uint64_t time, uint32_t recvProc, uint32_t sendProc, uint32_t group, uint32_t type, uint32_t length, uint32_t source, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = RECV;
+		e->time = time;
+		e->proc = recvProc;
+		e->a    = sendProc;
+		e->b    = group;
+		e->c    = type;
+		e->v    = length;
+		e->s    = source;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleCounter(void* userData, uint64_t time, uint32_t process, uint32_t counter, uint64_t value, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = COUNTER;
+		e->time = time;
+		e->proc = process;
+		e->a    = counter;
+		e->v    = value;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleBeginCollectiveOperation(void* userData, uint64_t time, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = BEGIN_COLLOP;
+		e->time = time;
+		e->proc = process;
+		e->a    = collOp;
+		e->b    = procGroup;
+		e->c    = rootProc;
+		e->v    = sent;
+		e->w    = received;
+		e->m    = matchingId;
+		e->s    = scltoken;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleEndCollectiveOperation(void* userData, uint64_t time, uint32_t process, uint64_t matchingId, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = END_COLLOP;
+		e->time = time;
+		e->proc = process;
+		e->m    = matchingId;
+		return OTF_RETURN_OK;
+	}
+
+	static int rma(void* userData, EventKind kind, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = kind;
+		e->time = time;
+		e->proc = process;
+		e->a    = origin;
+		e->b    = target;
+		e->c    = communicator;
+		e->v    = bytes;
+		e->w    = tag;
+		e->s    = source;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleRMAPut(void* userData, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source, OTF_KeyValueList *list)
+	{
+		return rma(userData, RMA_PUT, time, process, origin, target, communicator, tag, bytes, source);
+	}
+
+	static int handleRMAPutRemoteEnd(void* userData, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source, OTF_KeyValueList *list)
+	{
+		return rma(userData, RMA_PUT_RE, time, process, origin, target, communicator, tag, bytes, source);
+	}
+
+	static int handleRMAGet(void* userData, uint64_t time, uint32_t process, uint32_t origin, uint32_t target, uint32_t communicator, uint32_t tag, uint64_t bytes, uint32_t source, OTF_KeyValueList *list)
+	{
+		return rma(userData, RMA_GET, time, process, origin, target, communicator, tag, bytes, source);
+	}
+
+	static int handleRMAEnd(void* userData, uint64_t time, uint32_t process, uint32_t remote, uint32_t communicator, uint32_t tag, uint32_t source, OTF_KeyValueList *list)
+	{
+		return rma(userData, RMA_END, time, process, remote, 0, communicator, tag, 0, source);
+	}
+
+	static int handleFileOperation(void* userData, uint64_t time, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t operation, uint64_t bytes, uint64_t duration, uint32_t source, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = FILEOP;
+		e->time = time;
+		e->proc = process;
+		e->a    = fileid;
+		e->c    = operation;
+		e->v    = bytes;
+		e->w    = handleid;
+		e->m    = duration;
+		e->s    = source;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleBeginFileOperation(void* userData, uint64_t time, uint32_t process, uint64_t matchingId, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = BEGIN_FILEOP;
+		e->time = time;
+		e->proc = process;
+		e->m    = matchingId;
+		e->s    = scltoken;
+		return OTF_RETURN_OK;
+	}
+
+	static int handleEndFileOperation(void* userData, uint64_t time, uint32_t process, uint32_t fileid, uint64_t matchingId, uint64_t handleId, uint32_t operation, uint64_t bytes, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		EventRecord *e = ((EventPipeline*)userData)->next();
+		if (e == nullptr)
+			return OTF_RETURN_ABORT;
+
+		e->kind = END_FILEOP;
+		e->time = time;
+		e->proc = process;
+		e->a    = fileid;
+		e->c    = operation;
+		e->v    = bytes;
+		e->w    = handleId;
+		e->m    = matchingId;
+		e->s    = scltoken;
+		return OTF_RETURN_OK;
+	}
+
+	#pragma GCC diagnostic pop
+};
+
+uint64_t OTF_Manager::read_events_pipelined(bool unsorted)
+{
+	/*
+	 * Reads the events on this thread and runs the handlers on a second
+	 * one. The batches keep the order of the records, so the result equals
+	 * the one of the serial reader. Only the record kinds of EventRecord
+	 * are passed on; therefore this is not used for the raw output.
+	 */
+
+	OTF_HandlerArray *handlers = OTF_HandlerArray_open();
+	if (handlers == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	EventPipeline pipe;
+
+	using ofp = OTF_FunctionPointer*;
+	std::map<int, ofp> handleMap;
+
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"
+	handleMap[OTF_ENTER_RECORD]       = (ofp) &EventPipeline::handleEnter;
+	handleMap[OTF_LEAVE_RECORD]       = (ofp) &EventPipeline::handleLeave;
+	handleMap[OTF_SEND_RECORD]        = (ofp) &EventPipeline::handleSendMsg;
+	handleMap[OTF_RECEIVE_RECORD]     = (ofp) &EventPipeline::handleRecvMsg;
+	handleMap[OTF_COUNTER_RECORD]     = (ofp) &EventPipeline::handleCounter;
+	handleMap[OTF_BEGINCOLLOP_RECORD] = (ofp) &EventPipeline::handleBeginCollectiveOperation;
+	handleMap[OTF_ENDCOLLOP_RECORD]   = (ofp) &EventPipeline::handleEndCollectiveOperation;
+	handleMap[OTF_RMAPUT_RECORD]      = (ofp) &EventPipeline::handleRMAPut;
+	handleMap[OTF_RMAPUTRE_RECORD]    = (ofp) &EventPipeline::handleRMAPutRemoteEnd;
+	handleMap[OTF_RMAGET_RECORD]      = (ofp) &EventPipeline::handleRMAGet;
+	handleMap[OTF_RMAEND_RECORD]      = (ofp) &EventPipeline::handleRMAEnd;
+	handleMap[OTF_FILEOPERATION_RECORD] = (ofp) &EventPipeline::handleFileOperation;
+	handleMap[OTF_BEGINFILEOP_RECORD] = (ofp) &EventPipeline::handleBeginFileOperation;
+	handleMap[OTF_ENDFILEOP_RECORD]   = (ofp) &EventPipeline::handleEndFileOperation;
+	#pragma GCC diagnostic pop
+
+	for (auto &h:handleMap)
+	{
+		OTF_HandlerArray_setHandler(handlers, h.second, h.first);
+		OTF_HandlerArray_setFirstHandlerArg(handlers, &pipe, h.first);
+	}
+
+	std::exception_ptr error;
+
+	std::thread analysis([&]()
+	{
+		try
+		{
+			EventPipeline::Batch *batch = nullptr;
+			while (pipe.take(pipe.full, batch) && batch != nullptr)
+			{
+				sonar->dispatch(&udata, batch->events, batch->n);
+
+				batch->n = 0;
+				pipe.put(pipe.empty, batch);
+			}
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+			pipe.stop();
+		}
+	});
+
+	uint64_t read;
+	if (unsorted)
+		read = OTF_Reader_readEventsUnsorted(reader, handlers);
+	else
+		read = OTF_Reader_readEvents(reader, handlers);
+
+	pipe.finish();
+	analysis.join();
+	OTF_HandlerArray_close(handlers);
+
+	if (error)
+		std::rethrow_exception(error);
+
+	return read;
+}
+
+void OTF_Manager::close_cache(UserData &data)
+{
+	/* writes the remaining events of a (shard) cache and collects its processes */
+
+	const auto written = data.cache->close();
+	cached_procs.insert(written.begin(), written.end());
+
+	if (!data.cache->ok())
+		cache_ok = false;
+}
+
+// collects the timestamps of all snapshot records
+struct SnapshotTimes {
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+	static int handleSnapshotComment(void* userData, uint64_t time, uint32_t process, const char* comment, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleEnterSnapshot(void *userData, uint64_t time, uint64_t originaltime, uint32_t function, uint32_t process, uint32_t source, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleSendSnapshot(void *userData, uint64_t time, uint64_t originaltime, uint32_t sender, uint32_t receiver, uint32_t procGroup, uint32_t tag, uint32_t length, uint32_t source, OTF_KeyValueList *list )
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleOpenFileSnapshot(void* userData, uint64_t time, uint64_t originaltime, uint32_t fileid, uint32_t process, uint64_t handleid, uint32_t source, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleBeginCollopSnapshot(void* userData, uint64_t time, uint64_t originaltime, uint32_t process, uint32_t collOp, uint64_t matchingId, uint32_t procGroup, uint32_t rootProc, uint64_t sent, uint64_t received, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleBeginFileOpSnapshot(void* userData, uint64_t time, uint64_t originaltime, uint32_t process, uint64_t matchingId, uint32_t scltoken, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleCollopCountSnapshot(void* userData, uint64_t time, uint32_t process, uint32_t communicator, uint64_t count, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	static int handleCounterSnapshot(void* userData, uint64_t time, uint64_t originaltime, uint32_t process, uint32_t counter, uint64_t value, OTF_KeyValueList *list)
+	{
+		((std::set<uint64_t>*)userData)->insert(time);
+		return OTF_RETURN_OK;
+	}
+
+	#pragma GCC diagnostic pop
+};
+
+std::vector<uint64_t> OTF_Manager::slice_boundaries(uint32_t nslices)
+{
+	/*
+	 * Splits the time range of the trace into nslices equal parts and moves
+	 * every inner boundary back to the closest snapshot, the points the
+	 * trace writer chose for resuming a read.
+	 */
+
+	std::set<uint64_t> snapshots;
+
+	OTF_HandlerArray *handlers = OTF_HandlerArray_open();
+	if (handlers == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	using ofp = OTF_FunctionPointer*;
+	std::map<int, ofp> handleMap;
+
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wpedantic"
+	handleMap[OTF_SNAPSHOTCOMMENT_RECORD]     = (ofp) &SnapshotTimes::handleSnapshotComment;
+	handleMap[OTF_ENTERSNAPSHOT_RECORD]       = (ofp) &SnapshotTimes::handleEnterSnapshot;
+	handleMap[OTF_SENDSNAPSHOT_RECORD]        = (ofp) &SnapshotTimes::handleSendSnapshot;
+	handleMap[OTF_OPENFILESNAPSHOT_RECORD]    = (ofp) &SnapshotTimes::handleOpenFileSnapshot;
+	handleMap[OTF_BEGINCOLLOPSNAPSHOT_RECORD] = (ofp) &SnapshotTimes::handleBeginCollopSnapshot;
+	handleMap[OTF_BEGINFILEOPSNAPSHOT_RECORD] = (ofp) &SnapshotTimes::handleBeginFileOpSnapshot;
+	handleMap[OTF_COLLOPCOUNTSNAPSHOT_RECORD] = (ofp) &SnapshotTimes::handleCollopCountSnapshot;
+	handleMap[OTF_COUNTERSNAPSHOT_RECORD]     = (ofp) &SnapshotTimes::handleCounterSnapshot;
+	#pragma GCC diagnostic pop
+
+	for (auto &h:handleMap)
+	{
+		OTF_HandlerArray_setHandler(handlers, h.second, h.first);
+		OTF_HandlerArray_setFirstHandlerArg(handlers, &snapshots, h.first);
+	}
+
+	uint64_t read = OTF_Reader_readSnapshots(reader, handlers);
+	OTF_HandlerArray_close(handlers);
+	if (read == OTF_READ_ERROR)
+	{
+		throw std::runtime_error("Can not read the snapshots of the trace");
+	}
+
+	const auto begin = udata.ts->getOtfParam().time_begin;
+	const auto end   = udata.ts->getOtfParam().time_end;
+
+	std::set<uint64_t> bounds;
+	bounds.insert(begin);
+	for (uint32_t i=1; i<nslices; i++)
+	{
+		uint64_t t = begin + (end-begin) / nslices * i;
+
+		auto snap = snapshots.upper_bound(t);
+		if (snap != snapshots.begin() && *std::prev(snap) > begin)
+			t = *std::prev(snap);
+
+		bounds.insert(t);
+	}
+
+	return std::vector<uint64_t>(bounds.begin(), bounds.end());
+}
+
+uint64_t OTF_Manager::read_events_sliced(void)
+{
+	/*
+	 * Reads the trace in time slices, each with its own reader and its own
+	 * TraceStats/TraceVisualizer shard. A slice starts without the state
+	 * open at its begin (call stacks, collectives, file operations); it
+	 * keeps what it can not resolve itself and the shards are merged in
+	 * time order, the merge functions treat the later shard as the
+	 * continuation of the earlier one and resolve it there.
+	 */
+
+	const std::vector<uint64_t> bounds = slice_boundaries(udata.cfg->slices);
+	const uint32_t nworkers = std::max<uint32_t>(1, std::min<uint32_t>(udata.cfg->threads, bounds.size()));
+	if (udata.cfg->verbose)
+		std::cout << "Reading " << bounds.size() << " time slices with " << nworkers << " threads" << std::endl;
+
+	std::vector<UserData> shards = make_shards(bounds.size());
+
+	std::atomic<uint64_t> events     {0};
+	std::atomic<bool>     read_error {false};
+
+	auto read_slice = [&](uint32_t, size_t i)
+	{
+		const uint64_t begin = bounds[i];
+		const uint64_t end   = (i+1 < bounds.size()) ? bounds[i+1] : std::numeric_limits<uint64_t>::max();
+
+		OTF_FileManager  *smanager  = OTF_FileManager_open(num_files);
+		OTF_Reader       *sreader   = nullptr;
+		OTF_HandlerArray *shandlers = OTF_HandlerArray_open();
+
+		if (smanager != nullptr && shandlers != nullptr)
+			sreader = OTF_Reader_open(udata.cfg->otffile.c_str(), smanager);
+
+		if (sreader != nullptr)
+		{
+			sonar->set(shandlers, &shards[i]);
+			OTF_Reader_setBufferSizes(sreader, buffer_size);
+			OTF_Reader_setProcessStatusAll(sreader, 1);
+
+			OTF_Reader_setTimeInterval(sreader, begin, end);
+			uint64_t read = OTF_Reader_readEvents(sreader, shandlers);
+
+			if (read == OTF_READ_ERROR)
+				read_error = true;
+			else
+				events += read;
+
+			OTF_Reader_close(sreader);
+		}
+		else
+		{
+			read_error = true;
+		}
+
+		if (shandlers != nullptr)
+			OTF_HandlerArray_close(shandlers);
+		if (smanager != nullptr)
+			OTF_FileManager_close(smanager);
+	};
+
+	run_parallel(bounds.size(), nworkers, read_slice);
+
+	if (read_error)
+		return OTF_READ_ERROR;
+
+	for (auto &shard:shards)
+	{
+		sonar->flush(&shard);
+		udata.activity->merge(*shard.activity);
+		udata.ts->merge(*shard.ts);
+		udata.matcher->merge(*shard.matcher);
+		udata.colls->merge(*shard.colls);
+		udata.files->merge(*shard.files);
+		udata.tviz->merge(*shard.tviz);
+	}
+
+	return events;
+}
+
+std::vector<OTF_Manager::UserData> OTF_Manager::make_shards(size_t n)
+{
+	/* shards start with a copy of the definitions read so far */
+
+	std::vector<UserData> shards(n);
+	for (auto &shard:shards)
+	{
+		shard.cfg  = udata.cfg;
+		shard.ts   = std::make_shared<TraceStats>(*udata.ts);
+		shard.tviz = std::make_shared<TraceVisualizer>(udata.cfg, shard.ts, true);
+		shard.batches = TokenMap<MessageBatch>(shard.ts->getProcessIndex());
+		track_activity(shard, true);
+		match_messages(shard, true);
+		track_collectives(shard);
+		track_file_ops(shard);
+		if (udata.cache)
+			shard.cache = std::make_shared<EventCache>(udata.cache->dir);
+	}
+
+	return shards;
+}
+
+void OTF_Manager::track_activity(UserData &data, bool shard)
+{
+	/* the idle statistics and the inactivity histograms share the gaps between message events */
+
+	auto ts   = data.ts;
+	auto tviz = data.tviz;
+	data.activity = std::make_shared<ActivityTracker>(ts->getProcessIndex(), shard);
+	data.activity->subscribe([ts](uint32_t proc, const ActivityTracker::Gaps &gaps) { ts->addIdleGaps(proc, gaps); });
+	data.activity->subscribe([tviz](uint32_t proc, const ActivityTracker::Gaps &gaps) { tviz->addInactivityGaps(proc, gaps); });
+}
+
+void OTF_Manager::match_messages(UserData &data, bool shard)
+{
+	/* shards match the messages between their own processes, the others when merged into the main instance */
+
+	auto ts = data.ts;
+	data.matcher = std::make_shared<MessageMatcher>(shard);
+	data.matcher->subscribe([ts](const MessageMatcher::Match &match) { ts->addMessageMatch(match); });
+	if (data.cfg->wait_states)
+		data.matcher->subscribe([ts](const MessageMatcher::Match &match) { ts->addWaitStates(match); });
+}
+
+void OTF_Manager::track_collectives(UserData &data)
+{
+	/* instances completed in a shard are accounted there, the parts of the others when merged */
+
+	auto ts = data.ts;
+	data.colls = std::make_shared<CollectiveTracker>(ts->getProcessIndex());
+	data.colls->subscribe([ts](const CollectiveTracker::Instance &instance) { ts->addCollectiveInstance(instance); });
+}
+
+void OTF_Manager::track_file_ops(UserData &data)
+{
+	/* like the collectives: operations begun in an earlier shard complete when merged */
+
+	auto ts   = data.ts;
+	auto tviz = data.tviz;
+	data.files = std::make_shared<FileOpTracker>();
+	data.files->subscribe([ts](const FileOpTracker::Operation &op) { ts->addFileOperation(op); });
+	data.files->subscribe([tviz](const FileOpTracker::Operation &op) { tviz->addFileOperation(op); });
+}
+
+template<typename T, typename D>
+static void dispatch_events(D *data, const EventRecord *events, size_t n)
+{
+	/* feeds a batch of decoded events to the handlers of T */
+
+	for (size_t i=0; i<n; i++)
+		dispatch_event<T>(data, events[i]);
+}
+
+template<typename S>
+OTF_Manager::Handlers OTF_Manager::make_handlers(void)
+{
+	return {S::features(), &set_handler_Functions<S>, &replay_events<S, UserData>, &dispatch_events<S, UserData>, &S::flushBatches};
+}
+
+template<typename... M>
+void OTF_Manager::add_handlers(std::vector<Handlers> &table)
+{
+	/* the modules M alone, with the progress output, recording the event cache and both */
+
+	table.push_back(make_handlers<Sonar<UserData, M...>>());
+	table.push_back(make_handlers<Sonar<UserData, M..., Progress>>());
+	table.push_back(make_handlers<Sonar<UserData, M..., EventRecorder>>());
+	table.push_back(make_handlers<Sonar<UserData, M..., Progress, EventRecorder>>());
+}
+
+const OTF_Manager::Handlers& OTF_Manager::select_handlers(uint32_t needed)
+{
+	/*
+	 * Prebuilt combinations of the analysis modules, the first one covering
+	 * the needed features is used; it has exactly the SONAR_EXACT ones asked
+	 * for. Analyses left out of it cost nothing while reading the events,
+	 * those in it but not enabled only go unreported. The lean combinations
+	 * are chosen with --no-functions, --no-messages, --no-collectives and
+	 * --no-plots.
+	 */
+
+	static const std::vector<Handlers> table = []()
+	{
+		std::vector<Handlers> t {
+			make_handlers<Sonar<UserData, FunctionStats>>(),
+			make_handlers<Sonar<UserData, MsgStats, MsgMatch>>(),
+		};
+		add_handlers<FunctionStats, MsgStats, MsgMatch, CollStats, TraceViz>(t);
+		add_handlers<FunctionStats, Cct, MsgStats, MsgMatch, CollStats, TraceViz, MatrixStats, CallSites, RmaComm, FileIo>(t);
+		add_handlers<WaitStates, FunctionStats, Cct, MsgStats, CollStats, TraceViz, MatrixStats, CallSites, RmaComm, FileIo>(t);
+
+		// --rawotf reads in time order, which leaves out the cache
+		t.push_back(make_handlers<Sonar<UserData, RawOtf, FunctionStats, Cct, MsgStats, MsgMatch, CollStats, TraceViz, MatrixStats, CallSites, RmaComm, FileIo>>());
+		t.push_back(make_handlers<Sonar<UserData, RawOtf, FunctionStats, Cct, MsgStats, MsgMatch, CollStats, TraceViz, MatrixStats, CallSites, RmaComm, FileIo, Progress>>());
+		t.push_back(make_handlers<Sonar<UserData, RawOtf, WaitStates, FunctionStats, Cct, MsgStats, CollStats, TraceViz, MatrixStats, CallSites, RmaComm, FileIo>>());
+		t.push_back(make_handlers<Sonar<UserData, RawOtf, WaitStates, FunctionStats, Cct, MsgStats, CollStats, TraceViz, MatrixStats, CallSites, RmaComm, FileIo, Progress>>());
+		return t;
+	}();
+
+	for (const auto &h:table)
+		if ((needed & ~h.features) == 0 && (h.features & SONAR_EXACT) == (needed & SONAR_EXACT))
+			return h;
+
+	throw std::logic_error("No handlers for the analyses " + std::to_string(needed));
+}
+
+void OTF_Manager::use_handlers(uint32_t features)
+{
+	sonar = &select_handlers(features);
+	sonar->set(handler_array, &udata);
+}
+
 template<typename T>
-void OTF_Manager::set_handler_Functions(void)
+void OTF_Manager::set_handler_Functions(OTF_HandlerArray *handlers, UserData *data)
 {
 	using ofp = OTF_FunctionPointer*;
 	std::map<int, ofp> handleMap;
@@ -152,6 +1219,7 @@ void OTF_Manager::set_handler_Functions(void)
 	handleMap[OTF_DEFCOUNTER_RECORD]            = (ofp) &T::handleDefCounter;
 	handleMap[OTF_DEFCOUNTERGROUP_RECORD]       = (ofp) &T::handleDefCounterGroup;
 	handleMap[OTF_DEFSCL_RECORD]                = (ofp) &T::handleDefScl;
+	handleMap[OTF_DEFSCLFILE_RECORD]            = (ofp) &T::handleDefSclFile;
 	handleMap[OTF_DEFCREATOR_RECORD]            = (ofp) &T::handleDefCreator;
 	handleMap[OTF_DEFUNIQUEID_RECORD]           = (ofp) &T::handleDefUniqueId;
 	handleMap[OTF_DEFVERSION_RECORD]            = (ofp) &T::handleDefVersion;
@@ -214,7 +1282,7 @@ void OTF_Manager::set_handler_Functions(void)
 	{
 		auto fkt_id  = h.first;
 		auto fkt_ptr = h.second;
-		OTF_HandlerArray_setHandler(handler_array, fkt_ptr, fkt_id);
-		OTF_HandlerArray_setFirstHandlerArg(handler_array, &udata, fkt_id);
+		OTF_HandlerArray_setHandler(handlers, fkt_ptr, fkt_id);
+		OTF_HandlerArray_setFirstHandlerArg(handlers, data, fkt_id);
 	}
 }
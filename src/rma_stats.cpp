@@ -0,0 +1,69 @@
+#include <rma_stats.h>
+
+void RmaStats::Transfer::add(uint64_t length, bool exact)
+{
+	ops++;
+	bytes += length;
+	min = std::min(min, length);
+	max = std::max(max, length);
+
+	if (sizes.empty())
+		sizes = SizeHistogram(exact);
+	sizes.add(length);
+}
+
+void RmaStats::Transfer::merge(const Transfer &other)
+{
+	ops   += other.ops;
+	bytes += other.bytes;
+	min = std::min(min, other.min);
+	max = std::max(max, other.max);
+	sizes.merge(other.sizes);
+}
+
+RmaStats::RmaStats(std::shared_ptr<const TokenIndex> index, bool exact_sizes) :
+	exact(exact_sizes),
+	procs(index),
+	put_matrix(index),
+	get_matrix(index)
+{
+}
+
+void RmaStats::addPut(uint32_t origin, uint32_t target, uint64_t bytes)
+{
+	procs[origin].put.add(bytes, exact);
+	procs[target].put_in.add(bytes, exact);
+	put_matrix.add(origin, target, 1, bytes);
+	puts.add(bytes, exact);
+}
+
+void RmaStats::addGet(uint32_t origin, uint32_t target, uint64_t bytes)
+{
+	procs[origin].get.add(bytes, exact);
+	procs[target].get_in.add(bytes, exact);
+	get_matrix.add(origin, target, 1, bytes);
+	gets.add(bytes, exact);
+}
+
+void RmaStats::addEnd(uint32_t proc)
+{
+	procs[proc].ends++;
+}
+
+void RmaStats::merge(const RmaStats &other)
+{
+	for (const auto &p:other.procs)
+	{
+		auto &to = procs[p.first];
+		to.put.merge(p.second.put);
+		to.get.merge(p.second.get);
+		to.put_in.merge(p.second.put_in);
+		to.get_in.merge(p.second.get_in);
+		to.ends += p.second.ends;
+	}
+
+	put_matrix.merge(other.put_matrix);
+	get_matrix.merge(other.get_matrix);
+	puts.merge(other.puts);
+	gets.merge(other.gets);
+}
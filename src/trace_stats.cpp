@@ -1,4 +1,5 @@
 #include <trace_stats.h>
+#include <otf.h>
 
 static inline void cutString(std::string& str, uint32_t cutTo)
 {
@@ -24,12 +25,35 @@ static inline double average(std::vector<double> v)
 	return sum / v.size();
 }
 
+template<typename T>
+static inline void csvValue(std::ostream& out, const std::vector<T>& v, uint32_t i)
+{
+	/* metrics which were not computed (e.g. in summary-only mode) are written as NA */
+
+	if (i < v.size())
+		out << v[i];
+	else
+		out << "NA";
+}
+
+template<typename T>
+static inline void csvAverage(std::ostream& out, const std::vector<T>& v)
+{
+	if (!v.empty())
+		out << average(v);
+	else
+		out << "NA";
+}
+
 struct NodeMetrics {
 	std::vector<double> verbosity {};
 	std::vector<double> msgrate {};
 	std::vector<double> mpi_idle_min {};
 	std::vector<double> mpi_idle_max {};
 	std::vector<double> mpi_idle_avg {};
+	std::vector<double> mpi_idle_p50 {};
+	std::vector<double> mpi_idle_p95 {};
+	std::vector<double> mpi_idle_p99 {};
 	std::vector<double> mpi_idle_tot {};
 	std::vector<uint64_t> msg_tx {};
 	std::vector<uint64_t> msg_rx {};
@@ -40,7 +64,8 @@ struct NodeMetrics {
 NodeMetrics metrics {};
 
 TraceStats::TraceStats(std::shared_ptr<Config> cfg) :
-	config(cfg)
+	config(cfg),
+	rma(proc_index, cfg->exact_sizes)
 {
 #ifdef DEBUG
 	ctor_msg(__PRETTY_FUNCTION__);
@@ -72,6 +97,8 @@ void TraceStats::addOtfResolution(uint64_t res)
 
 void TraceStats::addProcessGroup(uint32_t id, std::string name, uint32_t numMembers, std::set<uint32_t> members)
 {
+	comm_index->add(id);
+
 	process_group_map[id].name       = name;
 	process_group_map[id].numMembers = numMembers;
 	process_group_map[id].members    = members;
@@ -79,6 +106,8 @@ void TraceStats::addProcessGroup(uint32_t id, std::string name, uint32_t numMemb
 
 void TraceStats::addProcess(uint32_t id, std::string name, uint32_t parent)
 {
+	proc_index->add(id);
+
 	process_map[id].name = name;
 	process_map[id].parent = parent;
 }
@@ -90,6 +119,8 @@ void TraceStats::addFunctionGroup(uint32_t id, std::string name)
 
 void TraceStats::addFunction(uint32_t id, std::string name, uint32_t group, uint32_t source)
 {
+	func_index->add(id);
+
 	function_map[id].name = name;
 	function_map[id].group = group;
 	function_map[id].source = source;
@@ -102,9 +133,35 @@ void TraceStats::addCounterGroup(uint32_t id, std::string name)
 
 void TraceStats::addCounter(uint32_t id, std::string name, std::string unit, uint32_t group)
 {
+	const uint32_t idx = counter_index->add(id);
+
 	counter_map[id].group = group;
 	counter_map[id].name  = name;
 	counter_map[id].unit  = unit;
+
+	// classify once here, the counter records only do a table lookup
+	if (papi_slots.size() <= idx)
+		papi_slots.resize(idx+1, TokenIndex::npos);
+
+	if (name.substr(0, 4) != "PAPI")
+	{
+		papi_slots[idx] = TokenIndex::npos;
+		return;
+	}
+
+	// counters of the same name share a slot
+	auto it = std::find(papi_names.begin(), papi_names.end(), name);
+	const uint32_t slot = it - papi_names.begin();
+	if (it == papi_names.end())
+		papi_names.push_back(name);
+	papi_slots[idx] = slot;
+
+	if (name == "PAPI_FP_OPS")
+		papi_known[PAPI_FP_OPS] = slot;
+	else if (name == "PAPI_FP_INS")
+		papi_known[PAPI_FP_INS] = slot;
+	else if (name == "PAPI_TOT_CYC")
+		papi_known[PAPI_TOT_CYC] = slot;
 }
 
 void TraceStats::addCollective(uint32_t id, uint32_t type, std::string name)
@@ -113,97 +170,692 @@ void TraceStats::addCollective(uint32_t id, uint32_t type, std::string name)
 	coll_map[id].type = type;
 }
 
-void TraceStats::addPapiCounter(uint32_t proc, uint32_t counter, uint64_t value)
+void TraceStats::addSclFile(uint32_t id, std::string name)
+{
+	scl_file_map[id] = name;
+}
+
+void TraceStats::addScl(uint32_t id, uint32_t file, uint32_t line)
+{
+	scl_index->add(id);
+
+	scl_map[id].file = file;
+	scl_map[id].line = line;
+}
+
+void TraceStats::addFileGroup(uint32_t id, std::string name)
+{
+	file_group_map[id] = name;
+}
+
+void TraceStats::addFile(uint32_t id, std::string name, uint32_t group)
+{
+	file_index->add(id);
+
+	file_map[id].name  = name;
+	file_map[id].group = group;
+}
+
+std::string TraceStats::getFileName(uint32_t file)
+{
+	return file_map.count(file) ? file_map[file].name : "file " + std::to_string(file);
+}
+
+std::string TraceStats::getSclName(uint32_t scl)
+{
+	if (!scl_map.count(scl))
+		return "scl " + std::to_string(scl);
+
+	const auto &s = scl_map[scl];
+	auto file = scl_file_map.find(s.file);
+	return (file != scl_file_map.end() ? file->second : "file " + std::to_string(s.file)) + ":" + std::to_string(s.line);
+}
+
+uint32_t TraceStats::addPapiCounter(uint32_t proc, uint32_t counter, uint64_t value)
+{
+	const uint32_t slot = getPapiSlot(counter);
+	if (slot == TokenIndex::npos)
+		return slot;
+
+	auto &p = papi_counter[proc];
+	if (slot >= p.value.size())
+	{
+		p.value.resize(papi_names.size(), 0);
+		p.recorded.resize(papi_names.size(), 0);
+	}
+
+	p.value[slot]    = value;
+	p.recorded[slot] = 1;
+	return slot;
+}
+
+void TraceStats::addSendBatch(uint32_t proc, const MessageBatch::P2P &batch)
+{
+	msg_stats[proc].sent.add(batch.length, config->exact_sizes);
+}
+
+void TraceStats::addRecvBatch(uint32_t proc, const MessageBatch::P2P &batch)
+{
+	msg_stats[proc].recv.add(batch.length, config->exact_sizes);
+}
+
+void TraceStats::addCollBatch(uint32_t proc, const MessageBatch::Collective &batch)
 {
-	const std::string PAPI_OP = getCounterName(counter);
+	// consecutive collectives mostly share communicator and operation
+	CollectiveStatistics *stats = nullptr;
+	uint32_t comm = 0, op = 0;
+
+	for (size_t i=0; i<batch.time.size(); i++)
+	{
+		if (stats == nullptr || batch.comm[i] != comm || batch.op[i] != op)
+		{
+			comm  = batch.comm[i];
+			op    = batch.op[i];
+			stats = &coll_stats[comm][op];
+		}
+
+		stats->calls++;
+		stats->sent += batch.sent[i];
+		stats->recv += batch.recv[i];
+	}
+
+	// the data of collectives also counts as sent/received messages
+	msg_stats[proc].sent.add(batch.sent, config->exact_sizes);
+	msg_stats[proc].recv.add(batch.recv, config->exact_sizes);
+}
 
-	if (PAPI_OP.substr(0, 4) != "PAPI")
+void TraceStats::addMessageBatch(uint32_t proc, const MessageBatch &batch)
+{
+	if (batch.size() == 0)
 		return;
 
-	papi_counter[proc][PAPI_OP] = value;
+	if (!batch.send.time.empty())
+		addSendBatch(proc, batch.send);
+	if (!batch.recv.time.empty())
+		addRecvBatch(proc, batch.recv);
+	if (!batch.coll.time.empty())
+		addCollBatch(proc, batch.coll);
+}
+
+void TraceStats::addMatrixBatch(uint32_t proc, const MessageBatch &batch)
+{
+	for (size_t i=0; i<batch.send.peer.size(); i++)
+		comm_p2p.add(proc, batch.send.peer[i], 1, batch.send.length[i]);
+
+	for (size_t i=0; i<batch.coll.time.size(); i++)
+	{
+		auto &cb = coll_bytes[batch.coll.comm[i]][proc];
+		cb.sent += batch.coll.sent[i];
+		cb.recv += batch.coll.recv[i];
+		if (batch.coll.sent[i] > 0)
+			cb.sends++;
+	}
+}
+
+void TraceStats::addIdleGaps(uint32_t proc, const ActivityTracker::Gaps &gaps)
+{
+	// a collective is one event, one send and one receive
+	auto &idle = node_idle[proc];
+	for (size_t i=0; i<gaps.gap.size(); i++)
+	{
+		idle.add(gaps.gap[i]);
+		if (gaps.type[i] == MessageBatch::COLLECTIVE)
+		{
+			idle.add(0);
+			idle.add(0);
+		}
+	}
+}
+
+void TraceStats::addRmaPut(uint32_t origin, uint32_t target, uint64_t bytes)
+{
+	rma.addPut(origin, target, bytes);
+}
+
+void TraceStats::addRmaGet(uint32_t origin, uint32_t target, uint64_t bytes)
+{
+	rma.addGet(origin, target, bytes);
+}
+
+void TraceStats::addRmaEnd(uint32_t proc)
+{
+	rma.addEnd(proc);
 }
 
-void TraceStats::addCollectiveEvent(uint32_t proc, uint32_t communicator, uint32_t operation, uint32_t sent, uint32_t recv, uint64_t time)
+void TraceStats::applyRma(void)
 {
-	coll_stats[communicator][operation].calls++;
-	coll_stats[communicator][operation].sent += sent;
-	coll_stats[communicator][operation].recv += recv;
+	/*
+	 * Adds the one-sided transfers to the message statistics, once after
+	 * reading: a put is sent by its origin and received by its target, a
+	 * get the other way round.
+	 */
 
-	node_idle[proc].update(time);
+	const auto _add = [this](MessageStatistics::DirectionStats &to, const RmaStats::Transfer &from)
+	{
+		if (from.ops == 0)
+			return;
+
+		to.msgs  += from.ops;
+		to.bytes += from.bytes;
+		to.min = std::min(to.min, from.min);
+		to.max = std::max(to.max, from.max);
+		if (to.sizes.empty())
+			to.sizes = SizeHistogram(config->exact_sizes);
+		to.sizes.merge(from.sizes);
+	};
+
+	for (const auto &p:rma.processes())
+	{
+		auto &ms = msg_stats[p.first];
+		_add(ms.sent, p.second.put);
+		_add(ms.sent, p.second.get_in);
+		_add(ms.recv, p.second.put_in);
+		_add(ms.recv, p.second.get);
+	}
 }
 
-void TraceStats::addSendMsg(uint32_t proc, uint32_t len, uint64_t time)
+void TraceStats::FileIoStatistics::add(uint32_t op, uint64_t bytes, uint64_t time)
 {
-	msg_stats[proc].sent.msgs++;
-	msg_stats[proc].sent.bytes += len;
-	msg_stats[proc].sent.sizemap[len]++;
-	msg_stats[proc].sent.updateMinMax(len);
+	switch (op & OTF_FILEOP_BITS)
+	{
+		case OTF_FILEOP_READ:
+			reads++;
+			read_bytes += bytes;
+			read_time  += time;
+			break;
+		case OTF_FILEOP_WRITE:
+			writes++;
+			write_bytes += bytes;
+			write_time  += time;
+			break;
+		default:
+			others++;
+			other_time += time;
+	}
+}
 
-	node_idle[proc].update(time);
+void TraceStats::FileIoStatistics::merge(const FileIoStatistics &other)
+{
+	reads       += other.reads;
+	read_bytes  += other.read_bytes;
+	read_time   += other.read_time;
+	writes      += other.writes;
+	write_bytes += other.write_bytes;
+	write_time  += other.write_time;
+	others      += other.others;
+	other_time  += other.other_time;
 }
 
-void TraceStats::addRecvMsg(uint32_t proc, uint32_t len, uint64_t time)
+void TraceStats::addFileOperation(const FileOpTracker::Operation &op)
 {
-	msg_stats[proc].recv.msgs++;
-	msg_stats[proc].recv.bytes += len;
-	msg_stats[proc].recv.sizemap[len]++;
-	msg_stats[proc].recv.updateMinMax(len);
+	const uint64_t time = op.end > op.begin ? toNanoS(op.end) - toNanoS(op.begin) : 0;
+	io_procs[op.proc].add(op.op, op.bytes, time);
+	io_files[op.file].add(op.op, op.bytes, time);
+}
 
-	node_idle[proc].update(time);
+void TraceStats::setUnmatchedFileOps(uint64_t begins, uint64_t ends)
+{
+	unmatched_io_begins = begins;
+	unmatched_io_ends   = ends;
 }
 
-void TraceStats::addFktEnter(uint32_t proc, uint32_t func, uint64_t time)
+void TraceStats::addMessageMatch(const MessageMatcher::Match &match)
 {
-	uint32_t group = getFunctionGroup(func);
+	auto &ps = p2p_stats[match.sender][match.receiver];
+	ps.msgs++;
+	ps.bytes += match.length;
+	p2p_total.msgs++;
+	p2p_total.bytes += match.length;
+
+	const uint64_t send = toNanoS(match.send_time);
+	const uint64_t recv = toNanoS(match.recv_time);
+	if (recv < send)
+	{
+		p2p_negative++;
+		return;
+	}
+
+	const uint64_t latency = recv - send;
+	ps.latency.add(latency);
+	p2p_total.latency.add(latency);
 
-	if (fkt_stats[proc][group][func].enter == std::numeric_limits<uint64_t>::max())
+	if (latency > 0)
 	{
-		fkt_stats[proc][group][func].enter = time; // remember function entry
+		const uint64_t bandwidth = static_cast<uint64_t>(match.length * 1e9 / latency);
+		ps.bandwidth.add(bandwidth);
+		p2p_total.bandwidth.add(bandwidth);
 	}
-	else
+}
+
+uint64_t TraceStats::messageRegion(uint32_t proc, uint64_t time, bool send)
+{
+	// enter of the call the message was sent or received in
+	if (!call_stacks.count(proc) || call_stacks[proc].frames.empty())
+		return time;
+
+	auto &f = call_stacks[proc].frames.back();
+	if (send)
+		f.sends++;
+	return f.enter;
+}
+
+void TraceStats::addWaitStates(const MessageMatcher::Match &match)
+{
+	const uint64_t recv       = toNanoS(match.recv_time);
+	const uint64_t send_enter = match.send_region;
+	const uint64_t recv_enter = match.recv_region;
+
+	// receive posted before the send started
+	if (send_enter > recv_enter)
+	{
+		auto &ws = wait_states[match.receiver][match.sender];
+		ws.late_sender += std::min(send_enter, recv) - recv_enter;
+		ws.late_sender_msgs++;
+	}
+
+	// the send blocked until the receive was posted: the leave of its call
+	// is known once the call is left
+	if (call_stacks.count(match.sender))
+	{
+		auto &frames = call_stacks[match.sender].frames;
+		for (auto f = frames.rbegin(); f != frames.rend(); ++f)
+			if (f->enter == send_enter && f->sends > 0)
+			{
+				f->sends--;
+				if (send_enter < recv_enter)
+					late_receivers[match.sender].insert({send_enter, {recv_enter, match.receiver}});
+				return;
+			}
+	}
+
+	if (!send_regions.count(match.sender))
+		return;
+	auto &regions = send_regions[match.sender];
+	auto r = regions.find(send_enter);
+	if (r == regions.end())
+		return;
+
+	const uint64_t leave = r->second.leave;
+	if (--r->second.sends == 0)
+		regions.erase(r);
+	if (send_enter < recv_enter)
+		addLateReceiver(match.sender, match.receiver, send_enter, leave, recv_enter);
+}
+
+void TraceStats::addLateReceiver(uint32_t sender, uint32_t receiver, uint64_t send_enter, uint64_t send_leave, uint64_t recv_enter)
+{
+	auto &ws = wait_states[sender][receiver];
+	ws.late_receiver += std::min(recv_enter, send_leave) - send_enter;
+	ws.late_receiver_msgs++;
+}
+
+void TraceStats::setUnmatchedMessages(uint64_t sends, uint64_t recvs)
+{
+	unmatched_sends = sends;
+	unmatched_recvs = recvs;
+}
+
+void TraceStats::addCollectiveInstance(const CollectiveTracker::Instance &instance)
+{
+	uint64_t first_enter = std::numeric_limits<uint64_t>::max();
+	uint64_t last_enter  = 0;
+	uint64_t last_exit   = 0;
+	for (const auto &p:instance.participants)
 	{
-		std::stringstream msg;
-		msg <<
-			"consecutive ENTER-events\n" <<
-			"  p=" << proc << "\n" <<
-			"  g=" << group << "\n" <<
-			"  f=" << func << " (" << getFunctionName(func) << ")";
-		throw std::runtime_error(msg.str());
+		first_enter = std::min(first_enter, p.enter);
+		last_enter  = std::max(last_enter, p.enter);
+		last_exit   = std::max(last_exit, p.exit);
 	}
+
+	auto &cs = coll_stats[instance.comm][instance.op];
+	const uint64_t time = toNanoS(last_exit) - toNanoS(first_enter);
+	cs.instances++;
+	cs.time += time;
+	cs.max_time = std::max(cs.max_time, time);
+
+	for (const auto &p:instance.participants)
+	{
+		const uint64_t wait = toNanoS(last_enter) - toNanoS(p.enter);
+		cs.participants++;
+		cs.proc_time += toNanoS(p.exit) - toNanoS(p.enter);
+		cs.wait += wait;
+		coll_wait[p.proc] += wait;
+	}
+}
+
+void TraceStats::setUnfinishedCollectives(uint64_t instances, uint64_t ends)
+{
+	unfinished_colls    = instances;
+	unmatched_coll_ends = ends;
+}
+
+TraceStats::CallStack& TraceStats::getCallStack(uint32_t proc)
+{
+	// a new stack has no frames reserved yet, it may be a copied empty one
+	auto &stack = call_stacks[proc];
+	if (stack.frames.capacity() == 0)
+	{
+		stack.frames.reserve(64);
+		stack.open = TokenMap<uint32_t>(func_index);
+	}
+	return stack;
+}
+
+TokenMap<uint64_t>& TraceStats::outerDone(CallStack &stack)
+{
+	const size_t epoch = stack.leaves.size();
+	while (stack.outer_done.size() <= epoch)
+		stack.outer_done.emplace_back(func_index);
+	return stack.outer_done[epoch];
+}
+
+void TraceStats::addFktEnter(uint32_t proc, uint32_t func, uint64_t time)
+{
+	auto &stack = getCallStack(proc);
+	auto &frames = stack.frames;
+
+	// recursive calls are part of the inclusive time of the outermost one
+	const bool outer = stack.open[func]++ == 0;
+
+	frames.push_back({time, 0, func, CallTree::none, 0, outer});
+}
+
+void TraceStats::addCctEnter(uint32_t proc)
+{
+	// the call just entered by addFktEnter(), below the one it was made from
+	auto &stack  = getCallStack(proc);
+	auto &frames = stack.frames;
+	auto &tree   = stack.tree;
+
+	const size_t n = frames.size();
+	frames[n-1].node = tree.child(n == 1 ? tree.base(stack.leaves.size()) : frames[n-2].node, frames[n-1].func);
 }
 
 void TraceStats::addFktLeave(uint32_t proc, uint32_t func, uint64_t time)
 {
-	uint32_t group = getFunctionGroup(func);
+	leaveCall(proc, getCallStack(proc), func, time);
+}
+
+// token 0: no source code location recorded
+
+void TraceStats::addSiteCall(uint32_t scl)
+{
+	if (scl == 0)
+		return;
+	site_stats[scl].calls++;
+}
+
+void TraceStats::addSiteSend(uint32_t scl, uint64_t bytes)
+{
+	if (scl == 0)
+		return;
+	auto &ss = site_stats[scl];
+	ss.sent++;
+	ss.sent_bytes += bytes;
+}
+
+void TraceStats::addSiteRecv(uint32_t scl, uint64_t bytes)
+{
+	if (scl == 0)
+		return;
+	auto &ss = site_stats[scl];
+	ss.recv++;
+	ss.recv_bytes += bytes;
+}
+
+void TraceStats::addSiteCollective(uint32_t scl, uint64_t sent, uint64_t recv)
+{
+	if (scl == 0)
+		return;
+	auto &ss = site_stats[scl];
+	ss.colls++;
+	ss.coll_bytes += sent + recv;
+}
+
+void TraceStats::leaveCall(uint32_t proc, CallStack &stack, uint32_t func, uint64_t time)
+{
+	auto &frames = stack.frames;
+	if (frames.empty())
+	{
+		// entered before the part of the trace read here, or never
+		stack.leaves.push_back({time, stack.base_child, func});
+		stack.base_child = 0;
+		return;
+	}
 
-	if (fkt_stats[proc][group][func].enter != std::numeric_limits<uint64_t>::max())
+	const size_t depth = leaveDepth(frames, func);
+	if (depth == 0)
 	{
-		auto entry = fkt_stats[proc][group][func].enter;
-		auto leave = time;
+		unmatched_leaves++;
+		return;
+	}
+
+	while (frames.size() >= depth)
+	{
+		const CallFrame f = frames.back();
+		frames.pop_back();
+
+		const uint64_t incl = time - f.enter;
+		auto &fs = getFktStats(proc, f.func);
+		fs.calls++;
+		fs.excl += incl - f.child;
+		if (f.outer)
+		{
+			fs.time += incl;
+			outerDone(stack)[f.func] += incl;
+		}
+		stack.open[f.func]--;
+
+		if (f.node != CallTree::none)
+		{
+			auto &n = stack.tree.node(f.node);
+			n.calls++;
+			n.incl += incl;
+			n.excl += incl - f.child;
+		}
 
-		fkt_stats[proc][group][func].time += leave-entry;
-		fkt_stats[proc][group][func].calls++;
-		fkt_stats[proc][group][func].enter = std::numeric_limits<uint64_t>::max(); // reset entry time for next call-event
+		if (frames.empty())
+			stack.base_child += incl;
+		else
+			frames.back().child += incl;
 	}
-	else
+}
+
+size_t TraceStats::leaveDepth(const std::vector<CallFrame> &frames, uint32_t func)
+{
+	// function 0 leaves the current call (VampirTrace), calls without
+	// a leave of their own above the left one are closed with it
+	size_t depth = frames.size();
+	if (func != 0)
+		while (depth > 0 && frames[depth-1].func != func)
+			depth--;
+
+	return depth;
+}
+
+void TraceStats::addSendRegionLeave(uint32_t proc, uint32_t func, uint64_t time)
+{
+	// the calls the leave closes, innermost first, before leaveCall() drops them
+	auto &frames = getCallStack(proc).frames;
+	const size_t depth = leaveDepth(frames, func);
+	if (depth == 0)
+		return;
+
+	for (size_t i=frames.size(); i>=depth; i--)
+		leaveSendRegion(proc, frames[i-1], time);
+}
+
+void TraceStats::leaveSendRegion(uint32_t proc, const CallFrame &f, uint64_t time)
+{
+	// sends still to be matched find the leave here
+	if (f.sends > 0)
+	{
+		auto &r = send_regions[proc][f.enter];
+		r.leave = std::max(r.leave, time);
+		r.sends += f.sends;
+	}
+
+	if (!late_receivers.count(proc))
+		return;
+	auto &lr = late_receivers[proc];
+	const auto range = lr.equal_range(f.enter);
+	for (auto r = range.first; r != range.second; ++r)
+		addLateReceiver(proc, r->second.receiver, f.enter, time, r->second.recv_enter);
+	lr.erase(range.first, range.second);
+}
+
+TraceStats::FunctionStatistics& TraceStats::getFktStats(uint32_t proc, uint32_t func)
+{
+	auto &fkts = fkt_stats[proc];
+	if (fkts.empty())
+		fkts = TokenMap<FunctionStatistics>(func_index);
+	return fkts[func];
+}
+
+void TraceStats::addFunctionSummary(uint32_t proc, uint32_t func, uint64_t time, uint64_t invocations, uint64_t excl, uint64_t incl)
+{
+	auto &fs = fkt_summary[proc][func];
+	if (time < fs.time)
+		return;
+
+	fs.time        = time;
+	fs.invocations = invocations;
+	fs.excl        = excl;
+	fs.incl        = incl;
+}
+
+void TraceStats::addMessageSummary(uint32_t proc, uint32_t peer, uint32_t communicator, uint32_t type, uint64_t time, uint64_t sent, uint64_t recv, uint64_t sentBytes, uint64_t recvBytes)
+{
+	auto &ms = msg_summary[proc][std::make_tuple(peer, communicator, type)];
+	if (time < ms.time)
+		return;
+
+	ms.time      = time;
+	ms.sent      = sent;
+	ms.recv      = recv;
+	ms.sentBytes = sentBytes;
+	ms.recvBytes = recvBytes;
+}
+
+void TraceStats::addCollopSummary(uint32_t proc, uint32_t communicator, uint32_t operation, uint64_t time, uint64_t sent, uint64_t recv, uint64_t sentBytes, uint64_t recvBytes)
+{
+	auto &cs = coll_summary[proc][std::make_pair(communicator, operation)];
+	if (time < cs.time)
+		return;
+
+	cs.time      = time;
+	cs.sent      = sent;
+	cs.recv      = recv;
+	cs.sentBytes = sentBytes;
+	cs.recvBytes = recvBytes;
+}
+
+void TraceStats::applySummaries(void)
+{
+	/*
+	 * Fills the statistics from the summary records (summary-only mode).
+	 * A token of 0 marks a record aggregated over all peers, communicators
+	 * or operations; these are only used if no detailed records exist.
+	 */
+
+	for (const auto &p:fkt_summary)
+		for (const auto &f:p.second)
+		{
+			if (f.first == 0)
+				continue;
+
+			auto &fs = getFktStats(p.first, f.first);
+			fs.calls += f.second.invocations;
+			fs.time  += toNanoS(f.second.incl);
+			fs.excl  += toNanoS(f.second.excl);
+		}
+
+	for (const auto &p:msg_summary)
+	{
+		bool detailed = false;
+		for (const auto &m:p.second)
+			if (std::get<0>(m.first) != 0)
+				detailed = true;
+
+		auto &ms = msg_stats[p.first];
+		for (const auto &m:p.second)
+		{
+			if ((std::get<0>(m.first) != 0) != detailed)
+				continue;
+
+			ms.sent.msgs  += m.second.sent;
+			ms.sent.bytes += m.second.sentBytes;
+			ms.recv.msgs  += m.second.recv;
+			ms.recv.bytes += m.second.recvBytes;
+		}
+	}
+
+	// like the messages; aggregated records only count into the message
+	// totals, the collective statistics need communicator and operation
+	for (const auto &p:coll_summary)
 	{
-		std::stringstream msg;
-		msg <<
-			"consecutive LEAVE-events\n" <<
-			"  p=" << proc << "\n" <<
-			"  g=" << group << "\n" <<
-			"  f=" << func << " (" << getFunctionName(func) << ")";
-		throw std::runtime_error(msg.str());
+		bool detailed = false;
+		for (const auto &c:p.second)
+			if (c.first.first != 0 && c.first.second != 0)
+				detailed = true;
+
+		auto &ms = msg_stats[p.first];
+		for (const auto &c:p.second)
+		{
+			const auto comm = c.first.first;
+			const auto op   = c.first.second;
+			if ((comm != 0 && op != 0) != detailed)
+				continue;
+
+			if (detailed)
+			{
+				auto &cs = coll_stats[comm][op];
+				cs.calls += std::max(c.second.sent, c.second.recv);
+				cs.sent  += c.second.sentBytes;
+				cs.recv  += c.second.recvBytes;
+			}
+
+			// as for collective events, the traffic counts into the message totals
+			ms.sent.msgs  += c.second.sent;
+			ms.sent.bytes += c.second.sentBytes;
+			ms.recv.msgs  += c.second.recv;
+			ms.recv.bytes += c.second.recvBytes;
+		}
 	}
+
+	fkt_summary.clear();
+	msg_summary.clear();
+	coll_summary.clear();
+}
+
+uint64_t TraceStats::getPapiValue(uint32_t proc, PapiKnown counter)
+{
+	const uint32_t slot = papi_known[counter];
+	if (slot == TokenIndex::npos || papi_counter.count(proc) == 0)
+		return 0;
+
+	const auto &p = papi_counter[proc];
+	return slot < p.value.size() ? p.value[slot] : 0;
+}
+
+uint32_t TraceStats::getPapiSlot(uint32_t cid)
+{
+	const uint32_t idx = counter_index->find(cid);
+	return idx < papi_slots.size() ? papi_slots[idx] : TokenIndex::npos;
+}
+
+const std::vector<std::string>& TraceStats::getPapiNames(void) const
+{
+	return papi_names;
 }
 
 uint64_t TraceStats::getFlops(uint32_t proc)
 {
-	if (papi_counter[proc]["PAPI_FP_OPS"] > 0)
-		return papi_counter[proc]["PAPI_FP_OPS"];
+	if (getPapiValue(proc, PAPI_FP_OPS) > 0)
+		return getPapiValue(proc, PAPI_FP_OPS);
 
-	if (papi_counter[proc]["PAPI_FP_INS"] > 0)
-		return papi_counter[proc]["PAPI_FP_INS"];
+	if (getPapiValue(proc, PAPI_FP_INS) > 0)
+		return getPapiValue(proc, PAPI_FP_INS);
 
 	std::cout << "Warning: no PAPI_FP_OPS or PAPI_FP_INS recorded" << std::endl;
 	return 0;
@@ -317,14 +969,30 @@ uint32_t TraceStats::getCollectiveType(uint32_t collid)
 
 uint32_t TraceStats::getCommunicatorSize(uint32_t groupid)
 {
-	return getCommunicatorMembers(groupid).size();
+	/* 0 for unknown communicators, called while reading events: must not add them */
+
+	auto it = process_group_map.find(groupid);
+	return it != process_group_map.end() ? it->second.members.size() : 0;
 }
 
-std::set<uint32_t> TraceStats::getCollectiveCommunicators(void)
+std::map<uint32_t, uint32_t> TraceStats::getMembersAmong(const std::vector<uint32_t> &procs)
 {
-	/* returns all the communicators which were used by coll. operations */
+	/* members of every communicator among procs */
 
-	std::set<uint32_t> s;
+	std::map<uint32_t, uint32_t> members;
+	for (const auto &g:process_group_map)
+		for (auto p:procs)
+			if (g.second.members.count(p))
+				members[g.first]++;
+
+	return members;
+}
+
+std::set<uint32_t> TraceStats::getCollectiveCommunicators(void)
+{
+	/* returns all the communicators which were used by coll. operations */
+
+	std::set<uint32_t> s;
 
 	for (auto c:coll_stats)
 	{
@@ -401,14 +1069,12 @@ uint32_t TraceStats::getFunctionGroup(uint32_t fid)
 
 uint64_t TraceStats::getFunctionCalls(uint32_t pid, uint32_t fid)
 {
-	uint32_t gid = getFunctionGroup(fid);
-	return fkt_stats[pid][gid][fid].calls;
+	return getFktStats(pid, fid).calls;
 }
 
 double TraceStats::getFunctionTime(uint32_t pid, uint32_t fid)
 {
-	uint32_t gid = getFunctionGroup(fid);
-	return fkt_stats[pid][gid][fid].time/1e9;
+	return getFktStats(pid, fid).time/1e9;
 }
 
 std::string
@@ -430,7 +1096,7 @@ TraceStats::map2table(const std::string title, std::map<uint32_t, std::string>&
 }
 
 std::string
-TraceStats::map2table(const std::string title, std::map<uint32_t, ProcessParameters>& container)
+TraceStats::map2table(const std::string title, TokenMap<ProcessParameters>& container)
 {
 	std::stringstream buf;
 
@@ -485,7 +1151,7 @@ TraceStats::map2table(const std::string title, std::map<uint32_t, ProcessGroupPa
 }
 
 std::string
-TraceStats::map2table(const std::string title, std::map<uint32_t, FunctionParameters>& container)
+TraceStats::map2table(const std::string title, TokenMap<FunctionParameters>& container)
 {
 	std::stringstream buf;
 
@@ -509,7 +1175,7 @@ TraceStats::map2table(const std::string title, std::map<uint32_t, FunctionParame
 }
 
 std::string
-TraceStats::map2table(const std::string title, std::map<uint32_t, CounterParameters>& container)
+TraceStats::map2table(const std::string title, TokenMap<CounterParameters>& container)
 {
 	std::stringstream buf;
 
@@ -533,24 +1199,35 @@ TraceStats::map2table(const std::string title, std::map<uint32_t, CounterParamet
 }
 
 std::string
-TraceStats::msgs2table(const std::string title, std::map<uint32_t, MessageStatistics>& container)
+TraceStats::msgs2table(const std::string title, TokenMap<MessageStatistics>& container)
 {
 	//const???
-	auto _printStats = [](std::string subtitle, MessageStatistics::DirectionStats& ds)
+	auto _printStats = [this](std::string subtitle, MessageStatistics::DirectionStats& ds)
 	{
 		std::stringstream buf;
 
 		buf << subtitle << '\n';
-		if (ds.msgs > 0 && ds.bytes > 0)
+		if (ds.msgs > 0 && ds.bytes > 0 && config->summary_only)
+		{
+			// summary records only hold the totals
+			buf << "Summary" << '\n';
+			buf
+				<< "  Total : " << ds.bytes << " Bytes, " << ds.msgs << " Messages" << '\n'
+				<< "  Details, Min, Max skipped (no event records read in summary-only mode)" << '\n';
+		}
+		else if (ds.msgs > 0 && ds.bytes > 0)
 		{
+			// exact sizes, or the size ranges of the log buckets
+			const int width = ds.sizes.isExact() ? 9 : 21;
 			buf << "Details" << '\n';
-			for (const auto y:ds.sizemap)
+			ds.sizes.forEach([&buf, &ds, width](uint64_t lower, uint64_t upper, uint64_t count)
 			{
+				const auto size = lower == upper ? std::to_string(lower) : std::to_string(lower) + "-" + std::to_string(upper);
 				buf << "  "
-					<< std::setfill(' ') << std::setw(9) << y.first << " Bytes: "
-					<< std::setfill(' ') << std::setw(5) << y.second << "x "
-					<< std::setprecision(3) << "(" << (static_cast<double>(y.second) / static_cast<double>(ds.msgs)*100) << "%)" << '\n';
-			}
+					<< std::setfill(' ') << std::setw(width) << size << " Bytes: "
+					<< std::setfill(' ') << std::setw(5) << count << "x "
+					<< std::setprecision(3) << "(" << (static_cast<double>(count) / static_cast<double>(ds.msgs)*100) << "%)" << '\n';
+			});
 			buf << '\n';
 
 			buf << "Summary" << '\n';
@@ -647,26 +1324,31 @@ TraceStats::msgs2table(const std::string title, std::map<uint32_t, MessageStatis
 }
 
 std::string
-TraceStats::fkts2table(const std::string title, std::map<uint32_t,std::map<uint32_t,std::map<uint32_t, FunctionStatistics>>>& container)
+TraceStats::fkts2table(const std::string title, TokenMap<TokenMap<FunctionStatistics>>& container)
 {
 	std::stringstream buf;
 
 	buf << title << '\n';
-	for (const auto m1:container)
+	for (const auto &m1:container)
 	{
 		const auto p = m1.first;
 		buf << "---------------------------------------------------" << '\n';
 		buf << "Process " << p << '\n';
 		buf << "---------------------------------------------------" << '\n';
 
-		for (const auto m2:m1.second)
+		// by function group
+		std::map<uint32_t, std::vector<std::pair<uint32_t, FunctionStatistics>>> groups;
+		for (const auto &f:m1.second)
+			groups[getFunctionGroup(f.first)].push_back(f);
+
+		for (const auto &m2:groups)
 		{
 			const auto g = m2.first;
 			std::string gname = getGroupName(g);
 			if (gname == "") gname = "unspecified group";
 			buf << "/--- " << gname << " ---\\" << '\n';
 
-			for (const auto m3:m2.second)
+			for (const auto &m3:m2.second)
 			{
 				const auto f = m3.first;
 				std::string fname = getFunctionName(f);
@@ -674,13 +1356,14 @@ TraceStats::fkts2table(const std::string title, std::map<uint32_t,std::map<uint3
 				if (!config->verbose)
 					cutString(fname, 25);
 
-				const auto fpercentage = static_cast<double>(m3.second.time) / static_cast<double>(getApplicationTime()) * 100.0;
+				const auto fpercentage = static_cast<double>(m3.second.time)/1e9 / static_cast<double>(getApplicationTime()) * 100.0;
 
 				buf << "|--> "
 					<< std::setw(30) << fname << " : "
 					<< std::setw(10) << m3.second.calls << " calls, "
 					<< std::setw(10) << std::setprecision(3) << m3.second.time/1e9 << " seconds"
-					<< " (" << std::setprecision(4) << fpercentage << "%)"
+					<< " (" << std::setprecision(4) << fpercentage << "%), "
+					<< std::setw(10) << std::setprecision(3) << m3.second.excl/1e9 << " seconds exclusive"
 					<< '\n';
 			}
 			buf << '\n';
@@ -691,7 +1374,7 @@ TraceStats::fkts2table(const std::string title, std::map<uint32_t,std::map<uint3
 	return buf.str();
 }
 
-std::string TraceStats::coll2table(const std::string title, std::map<uint32_t, std::map<uint32_t, CollectiveStatistics>>& container)
+std::string TraceStats::coll2table(const std::string title, TokenMap<std::map<uint32_t, CollectiveStatistics>>& container)
 {
 	std::stringstream buf;
 
@@ -707,20 +1390,774 @@ std::string TraceStats::coll2table(const std::string title, std::map<uint32_t, s
 			buf << "  calls: " << o.second.calls << '\n';
 			buf << "  sent : " << o.second.sent << " Bytes\n";
 			buf << "  recv : " << o.second.recv << " Bytes\n";
+			if (o.second.instances > 0)
+			{
+				buf << "  time : " << o.second.time / 1e9 << " s in " << o.second.instances << " instances (max " << o.second.max_time / 1e9 << " s)\n";
+				buf << "  busy : " << o.second.proc_time / 1e9 << " s summed over " << o.second.participants << " participants\n";
+				buf << "  wait : " << o.second.wait / 1e9 << " s (arrival skew)\n";
+			}
 			buf << '\n';
 		}
 		buf << '\n';
 	}
+
+	if (!coll_wait.empty())
+	{
+		buf << "Wait time per process (arrival skew):" << '\n';
+		buf << "---------------------------------------------------" << '\n';
+		for (const auto w:coll_wait)
+			buf << "  Process " << w.first << " : " << w.second / 1e9 << " s\n";
+		buf << '\n';
+	}
+	if (unfinished_colls > 0 || unmatched_coll_ends > 0)
+		buf << "Unfinished instances: " << unfinished_colls << ", ends without begin: " << unmatched_coll_ends << '\n';
+	buf << '\n';
+
+	return buf.str();
+}
+
+void TraceStats::writeCommMatrix(void)
+{
+	const std::string dir = config->resdir + "/";
+	comm_p2p.writeBinary(dir + "comm_matrix_p2p.bin");
+
+	// the bytes a process sends in collectives go to the other participants
+	// in proportion to what they receive (exact for uniform exchanges), a
+	// call that sent data counts as one message to every receiving participant
+	CommMatrix coll(proc_index);
+	for (const auto &c:coll_bytes)
+	{
+		// dense: listed as skipped in the stats instead
+		if (c.second.size() > coll_matrix_members)
+			continue;
+
+		uint64_t recv = 0;
+		for (const auto &p:c.second)
+			recv += p.second.recv;
+
+		for (const auto &from:c.second)
+		{
+			const uint64_t others = recv - from.second.recv;
+			if (from.second.sent == 0 || others == 0)
+				continue;
+
+			for (const auto &to:c.second)
+				if (to.first != from.first && to.second.recv > 0)
+					coll.add(from.first, to.first, from.second.sends, std::llround(static_cast<double>(from.second.sent) * to.second.recv / others));
+		}
+	}
+	coll.writeBinary(dir + "comm_matrix_coll.bin");
+
+	// dense tables and heatmaps only for small traces
+	if (getNumProcesses() > 256)
+		return;
+
+	// plotted by TraceVisualizer
+	comm_p2p.writeCsv(dir + "comm_matrix_p2p.csv");
+	coll.writeCsv(dir + "comm_matrix_coll.csv");
+}
+
+std::string TraceStats::matrix2table(const std::string title)
+{
+	std::stringstream buf;
+
+	buf << title << '\n';
+	buf << "===================================================" << '\n';
+	if (config->summary_only)
+	{
+		buf << "  skipped (no event records read in summary-only mode)\n";
+		return buf.str();
+	}
+
+	buf << "  sparse (CSR)       : comm_matrix_p2p.bin, comm_matrix_coll.bin" << '\n';
+	if (getNumProcesses() <= 256)
+		buf << "  dense / heatmaps   : comm_matrix_*.csv, comm_matrix_*.png" << '\n';
+
+	for (const auto &c:coll_bytes)
+		if (c.second.size() > coll_matrix_members)
+			buf << "  skipped communicator " << getCommunicatorName(c.first) << " (" << c.second.size()
+				<< " processes, more than " << coll_matrix_members << "), its collectives are not in comm_matrix_coll" << '\n';
+	buf << '\n';
+
+	return buf.str();
+}
+
+std::string TraceStats::rma2table(const std::string title)
+{
+	std::stringstream buf;
+
+	buf << title << '\n';
+	buf << "===================================================" << '\n';
+	if (config->summary_only)
+	{
+		buf << "  skipped (no event records read in summary-only mode)\n";
+		return buf.str();
+	}
+
+	auto _printTransfer = [&buf](const std::string name, const RmaStats::Transfer &t)
+	{
+		buf << name << t.ops << " ops, " << t.bytes << " bytes";
+		if (t.ops > 0)
+			buf << " (min " << t.min << "  avg " << t.bytes / t.ops << "  max " << t.max << ")";
+		buf << '\n';
+	};
+	_printTransfer("  puts               : ", rma.totalPuts());
+	_printTransfer("  gets               : ", rma.totalGets());
+	buf << "  (added to the message statistics)" << '\n';
+
+	for (const auto &p:rma.processes())
+	{
+		const auto &rp = p.second;
+		buf << "    p" << p.first
+			<< "  put " << rp.put.ops << " / " << rp.put.bytes << " B"
+			<< "  get " << rp.get.ops << " / " << rp.get.bytes << " B"
+			<< "  as target: put " << rp.put_in.ops << " / " << rp.put_in.bytes << " B"
+			<< ", get " << rp.get_in.ops << " / " << rp.get_in.bytes << " B"
+			<< "  ends " << rp.ends << '\n';
+	}
+	buf << "  per process        : rma_procs.csv, rma_sizes.csv, rma_matrix_*" << '\n';
 	buf << '\n';
 
 	return buf.str();
 }
 
+void TraceStats::writeRma(void)
+{
+	const std::string dir = config->resdir + "/";
+	const char sep = ',';
+
+	std::ofstream procs(dir + "rma_procs.csv", std::ofstream::out);
+	procs << "process,puts,put_bytes,gets,get_bytes,puts_in,put_in_bytes,gets_in,get_in_bytes,ends" << '\n';
+	for (const auto &p:rma.processes())
+	{
+		const auto &rp = p.second;
+		procs << p.first
+			<< sep << rp.put.ops << sep << rp.put.bytes
+			<< sep << rp.get.ops << sep << rp.get.bytes
+			<< sep << rp.put_in.ops << sep << rp.put_in.bytes
+			<< sep << rp.get_in.ops << sep << rp.get_in.bytes
+			<< sep << rp.ends << '\n';
+	}
+	procs.close();
+
+	std::ofstream sizes(dir + "rma_sizes.csv", std::ofstream::out);
+	sizes << "kind,lower,upper,count" << '\n';
+	rma.totalPuts().sizes.forEach([&sizes, sep](uint64_t lower, uint64_t upper, uint64_t count)
+	{
+		sizes << "put" << sep << lower << sep << upper << sep << count << '\n';
+	});
+	rma.totalGets().sizes.forEach([&sizes, sep](uint64_t lower, uint64_t upper, uint64_t count)
+	{
+		sizes << "get" << sep << lower << sep << upper << sep << count << '\n';
+	});
+	sizes.close();
+
+	rma.putMatrix().writeBinary(dir + "rma_matrix_put.bin");
+	rma.getMatrix().writeBinary(dir + "rma_matrix_get.bin");
+	if (getNumProcesses() <= 256)
+	{
+		rma.putMatrix().writeCsv(dir + "rma_matrix_put.csv");
+		rma.getMatrix().writeCsv(dir + "rma_matrix_get.csv");
+	}
+}
+
+std::string TraceStats::io2table(const std::string title)
+{
+	std::stringstream buf;
+
+	buf << title << '\n';
+	buf << "===================================================" << '\n';
+	if (config->summary_only)
+	{
+		buf << "  skipped (no event records read in summary-only mode)\n";
+		return buf.str();
+	}
+
+	FileIoStatistics total;
+	for (const auto &p:io_procs)
+		total.merge(p.second);
+
+	// achieved bandwidth: bytes over the time spent in the operations
+	auto _bandwidth = [](uint64_t bytes, uint64_t time)
+	{
+		return time > 0 ? bytes * 1e3 / time : 0.0; // MB/s
+	};
+	auto _printIo = [&buf, &_bandwidth](const std::string name, const FileIoStatistics &io)
+	{
+		buf << name
+			<< "read " << io.reads << " ops / " << io.read_bytes << " B / " << io.read_time / 1e9 << " s"
+			<< " (" << _bandwidth(io.read_bytes, io.read_time) << " MB/s)"
+			<< "  write " << io.writes << " ops / " << io.write_bytes << " B / " << io.write_time / 1e9 << " s"
+			<< " (" << _bandwidth(io.write_bytes, io.write_time) << " MB/s)"
+			<< "  other " << io.others << " ops / " << io.other_time / 1e9 << " s" << '\n';
+	};
+
+	_printIo("  total : ", total);
+	buf << "  unmatched begins   : " << unmatched_io_begins << '\n';
+	buf << "  unmatched ends     : " << unmatched_io_ends << '\n';
+	for (const auto &p:io_procs)
+		_printIo("    p" + std::to_string(p.first) + "  ", p.second);
+	for (const auto &f:io_files)
+		_printIo("    " + getFileName(f.first) + "  ", f.second);
+	buf << "  per process / file : io_procs.csv, io_files.csv, io-p*.csv" << '\n';
+	buf << '\n';
+
+	return buf.str();
+}
+
+void TraceStats::writeFileIo(void)
+{
+	const char sep = ',';
+	const std::string header = "read_ops,read_bytes,read_s,read_MBs,write_ops,write_bytes,write_s,write_MBs,other_ops,other_s";
+
+	auto _write = [sep](std::ostream &out, const FileIoStatistics &io)
+	{
+		out << sep << io.reads << sep << io.read_bytes << sep << io.read_time / 1e9
+			<< sep << (io.read_time > 0 ? io.read_bytes * 1e3 / io.read_time : 0.0)
+			<< sep << io.writes << sep << io.write_bytes << sep << io.write_time / 1e9
+			<< sep << (io.write_time > 0 ? io.write_bytes * 1e3 / io.write_time : 0.0)
+			<< sep << io.others << sep << io.other_time / 1e9 << '\n';
+	};
+
+	std::ofstream procs(config->resdir + "/io_procs.csv", std::ofstream::out);
+	procs << "process," << header << '\n';
+	for (const auto &p:io_procs)
+	{
+		procs << p.first;
+		_write(procs, p.second);
+	}
+	procs.close();
+
+	std::ofstream files(config->resdir + "/io_files.csv", std::ofstream::out);
+	files << "file,name," << header << '\n';
+	for (const auto &f:io_files)
+	{
+		files << f.first << sep << '"' << getFileName(f.first) << '"';
+		_write(files, f.second);
+	}
+	files.close();
+}
+
+std::string TraceStats::p2p2table(const std::string title)
+{
+	std::stringstream buf;
+
+	buf << title << '\n';
+	buf << "===================================================" << '\n';
+	if (config->summary_only)
+	{
+		buf << "  skipped (no event records read in summary-only mode)\n";
+		return buf.str();
+	}
+
+	buf << "  matched messages   : " << p2p_total.msgs << '\n';
+	buf << "  unmatched sends    : " << unmatched_sends << '\n';
+	buf << "  unmatched receives : " << unmatched_recvs << '\n';
+	if (p2p_negative > 0)
+		buf << "  received before sent (no latency): " << p2p_negative << '\n';
+
+	auto _printDistribution = [&buf](const std::string name, MessageGaps &d, double scale)
+	{
+		buf << name;
+		if (d.count == 0)
+		{
+			buf << " -\n";
+			return;
+		}
+		buf << " min " << d.getMin() / scale
+			<< "  avg " << d.getAvg() / scale
+			<< "  p50 " << d.getQuantile(0.50) / scale
+			<< "  p95 " << d.getQuantile(0.95) / scale
+			<< "  p99 " << d.getQuantile(0.99) / scale
+			<< "  max " << d.getMax() / scale << '\n';
+	};
+	_printDistribution("  latency   [us]    :", p2p_total.latency, 1e3);
+	_printDistribution("  bandwidth [MB/s]  :", p2p_total.bandwidth, 1e6);
+	buf << "  per process pair   : p2p_pairs.csv" << '\n';
+	buf << '\n';
+
+	return buf.str();
+}
+
+void TraceStats::writeP2PPairs(void)
+{
+	const char sep = ',';
+
+	std::ofstream out(config->resdir + "/p2p_pairs.csv", std::ofstream::out);
+	out << "sender,receiver,msgs,bytes,latency_min_us,latency_avg_us,latency_p50_us,latency_p95_us,latency_max_us,bandwidth_avg_MBs,bandwidth_p50_MBs" << '\n';
+	for (auto &p:p2p_stats)
+		for (auto &r:p.second)
+		{
+			auto &ps = r.second;
+			out << p.first << sep << r.first << sep << ps.msgs << sep << ps.bytes;
+			if (ps.latency.count > 0)
+				out << sep << ps.latency.getMin() / 1e3
+					<< sep << ps.latency.getAvg() / 1e3
+					<< sep << ps.latency.getQuantile(0.50) / 1e3
+					<< sep << ps.latency.getQuantile(0.95) / 1e3
+					<< sep << ps.latency.getMax() / 1e3;
+			else
+				out << sep << sep << sep << sep;
+			if (ps.bandwidth.count > 0)
+				out << sep << ps.bandwidth.getAvg() / 1e6 << sep << ps.bandwidth.getQuantile(0.50) / 1e6;
+			else
+				out << sep;
+			out << '\n';
+		}
+	out.close();
+}
+
+std::string TraceStats::wait2table(const std::string title)
+{
+	std::stringstream buf;
+
+	buf << title << '\n';
+	buf << "===================================================" << '\n';
+	if (config->summary_only)
+	{
+		buf << "  skipped (no event records read in summary-only mode)\n";
+		return buf.str();
+	}
+
+	// per waiting process, over all peers
+	std::map<uint32_t, WaitStates> procs;
+	WaitStates total;
+	for (const auto &p:wait_states)
+		for (const auto &r:p.second)
+		{
+			auto &ws = procs[p.first];
+			ws.late_sender        += r.second.late_sender;
+			ws.late_sender_msgs   += r.second.late_sender_msgs;
+			ws.late_receiver      += r.second.late_receiver;
+			ws.late_receiver_msgs += r.second.late_receiver_msgs;
+		}
+	for (const auto &p:procs)
+	{
+		total.late_sender        += p.second.late_sender;
+		total.late_sender_msgs   += p.second.late_sender_msgs;
+		total.late_receiver      += p.second.late_receiver;
+		total.late_receiver_msgs += p.second.late_receiver_msgs;
+	}
+
+	buf << "  late sender   [s]  : " << total.late_sender / 1e9 << " (" << total.late_sender_msgs << " msgs)" << '\n';
+	buf << "  late receiver [s]  : " << total.late_receiver / 1e9 << " (" << total.late_receiver_msgs << " msgs)" << '\n';
+	for (const auto &p:procs)
+		buf << "    p" << p.first
+			<< "  late sender " << p.second.late_sender / 1e9 << " s (" << p.second.late_sender_msgs << ")"
+			<< "  late receiver " << p.second.late_receiver / 1e9 << " s (" << p.second.late_receiver_msgs << ")" << '\n';
+	buf << "  per process pair   : wait_states.csv" << '\n';
+	buf << '\n';
+
+	return buf.str();
+}
+
+void TraceStats::writeWaitStates(void)
+{
+	const char sep = ',';
+
+	std::ofstream out(config->resdir + "/wait_states.csv", std::ofstream::out);
+	out << "process,peer,late_sender_s,late_sender_msgs,late_receiver_s,late_receiver_msgs" << '\n';
+	for (const auto &p:wait_states)
+		for (const auto &r:p.second)
+			out << p.first << sep << r.first
+				<< sep << r.second.late_sender / 1e9 << sep << r.second.late_sender_msgs
+				<< sep << r.second.late_receiver / 1e9 << sep << r.second.late_receiver_msgs << '\n';
+	out.close();
+}
+
+std::string TraceStats::sites2table(const std::string title)
+{
+	std::stringstream buf;
+
+	buf << title << '\n';
+	buf << "===================================================" << '\n';
+	if (config->summary_only)
+	{
+		buf << "  skipped (no event records read in summary-only mode)\n";
+		return buf.str();
+	}
+
+	std::vector<std::pair<uint32_t, const CallSiteStatistics*>> sites;
+	for (const auto &c:site_stats)
+		if (c.second.msgs() > 0)
+			sites.push_back({c.first, &c.second});
+	if (sites.empty())
+	{
+		buf << "  no messages or collectives with a source code location\n";
+		return buf.str();
+	}
+
+	const size_t n = std::min<size_t>(config->call_sites, sites.size());
+	auto _top = [&](const std::string heading, uint64_t (CallSiteStatistics::*key)(void) const)
+	{
+		// ties in token order
+		std::partial_sort(sites.begin(), sites.begin() + n, sites.end(),
+			[key](const std::pair<uint32_t, const CallSiteStatistics*> &a, const std::pair<uint32_t, const CallSiteStatistics*> &b)
+			{
+				const uint64_t ka = (a.second->*key)(), kb = (b.second->*key)();
+				return ka != kb ? ka > kb : a.first < b.first;
+			});
+
+		buf << heading << '\n';
+		buf << "---------------------------------------------------" << '\n';
+		for (size_t i=0; i<n; i++)
+		{
+			const auto &ss = *sites[i].second;
+			buf << "  " << std::setw(3) << i+1 << ". " << getSclName(sites[i].first)
+				<< "  bytes " << ss.bytes()
+				<< "  msgs " << ss.sent << " sent / " << ss.recv << " recv"
+				<< "  collectives " << ss.colls << '\n';
+		}
+	};
+	_top("Top call sites by bytes:", &CallSiteStatistics::bytes);
+	_top("Top call sites by messages and collectives:", &CallSiteStatistics::msgs);
+	buf << "  all call sites     : call_sites.csv" << '\n';
+	buf << '\n';
+
+	return buf.str();
+}
+
+void TraceStats::writeCallSites(void)
+{
+	const char sep = ',';
+
+	std::ofstream out(config->resdir + "/call_sites.csv", std::ofstream::out);
+	out << "scl,location,calls,msgs_sent,bytes_sent,msgs_recv,bytes_recv,collectives,coll_bytes" << '\n';
+	for (const auto &c:site_stats)
+	{
+		const auto &ss = c.second;
+		out << c.first << sep << '"' << getSclName(c.first) << '"'
+			<< sep << ss.calls
+			<< sep << ss.sent << sep << ss.sent_bytes
+			<< sep << ss.recv << sep << ss.recv_bytes
+			<< sep << ss.colls << sep << ss.coll_bytes << '\n';
+	}
+	out.close();
+}
+
+void TraceStats::writeCallTrees(void)
+{
+	// the same call path of all processes becomes one node of the global tree
+	struct Range {
+		uint64_t incl_min;
+		uint64_t incl_max;
+		uint64_t excl_min;
+		uint64_t excl_max;
+		uint32_t procs;
+	};
+	const Range empty {std::numeric_limits<uint64_t>::max(), 0, std::numeric_limits<uint64_t>::max(), 0, 0};
+
+	CallTree global;
+	const uint32_t root = global.base(0);
+	std::vector<Range> ranges;
+	std::vector<uint32_t> nodes;
+
+	for (const auto &s:call_stacks)
+	{
+		const auto &tree = s.second.tree;
+		if (tree.size() == 0)
+			continue;
+
+		// calls below open leaves (trace started inside a call) count as top level
+		CallTree proc;
+		const uint32_t proc_root = proc.base(0);
+		for (size_t b=0; b<tree.numBases(); b++)
+			proc.graft(proc_root, tree, tree.findBase(b), nodes);
+
+		nodes.assign(proc.size(), CallTree::none);
+		global.graft(root, proc, proc_root, nodes);
+		ranges.resize(global.size(), empty);
+
+		for (uint32_t n=0; n<proc.size(); n++)
+		{
+			if (nodes[n] == CallTree::none)
+				continue;
+
+			const auto &pn = proc.node(n);
+			auto &r = ranges[nodes[n]];
+			r.incl_min = std::min(r.incl_min, pn.incl);
+			r.incl_max = std::max(r.incl_max, pn.incl);
+			r.excl_min = std::min(r.excl_min, pn.excl);
+			r.excl_max = std::max(r.excl_max, pn.excl);
+			r.procs++;
+		}
+	}
+
+	// folded stacks (flame graphs) with the exclusive time in us summed over all
+	// processes, and per path the min/avg/max over the processes having it (s)
+	std::ofstream folded(config->resdir + "/cct.folded", std::ofstream::out);
+	std::ofstream csv(config->resdir + "/cct.csv", std::ofstream::out);
+	csv << "path,procs,calls,incl_min,incl_avg,incl_max,excl_min,excl_avg,excl_max" << '\n';
+
+	std::function<void(uint32_t, const std::string&)> walk = [&](uint32_t n, const std::string &path)
+	{
+		std::vector<std::pair<std::string, uint32_t>> children;
+		global.forEachChild(n, [&](uint32_t c)
+		{
+			std::string name = getFunctionName(global.node(c).func);
+			if (name.empty())
+				name = std::to_string(global.node(c).func);
+			std::replace_if(name.begin(), name.end(), [](char ch) { return ch == ';' || ch == ' ' || ch == ','; }, '_');
+			children.emplace_back(name, c);
+		});
+		std::sort(children.begin(), children.end());
+
+		for (const auto &c:children)
+		{
+			const auto &node = global.node(c.second);
+			const auto &r = ranges[c.second];
+			const std::string p = path.empty() ? c.first : path + ";" + c.first;
+
+			const uint64_t excl_us = (node.excl + 500) / 1000;
+			if (excl_us > 0)
+				folded << p << ' ' << excl_us << '\n';
+
+			csv << p << ',' << r.procs << ',' << node.calls << ','
+				<< r.incl_min / 1e9 << ',' << node.incl / 1e9 / r.procs << ',' << r.incl_max / 1e9 << ','
+				<< r.excl_min / 1e9 << ',' << node.excl / 1e9 / r.procs << ',' << r.excl_max / 1e9 << '\n';
+
+			walk(c.second, p);
+		}
+	};
+	walk(root, "");
+
+	folded.close();
+	csv.close();
+}
+
+bool
+TraceStats::needsTimeOrder(void) const
+{
+	/*
+	 * All statistics are accumulated per process (or are plain sums), and the
+	 * events of a process always come in time order within its stream.
+	 * An analysis that correlates events of different processes has to
+	 * return true here, unless it only relies on the order within each
+	 * process like the message matching (MessageMatcher).
+	 */
+
+	return false;
+}
+
+bool
+TraceStats::needsWholeProcesses(void) const
+{
+	/*
+	 * The wait states need the MPI call of both sides of a message; a call
+	 * split between two time slices would lose its enter or leave. Matches
+	 * in any order are fine: a send call still open waits for its leave,
+	 * the leave of a closed one is kept in send_regions.
+	 */
+
+	return config->wait_states;
+}
+
+void
+TraceStats::merge(const TraceStats &other)
+{
+	/*
+	 * Adds the event statistics of another instance (a shard of a parallel run).
+	 * For processes present in both, other has to hold the later events.
+	 */
+
+	const auto _mergeDirection = [](MessageStatistics::DirectionStats& to, const MessageStatistics::DirectionStats& from)
+	{
+		to.msgs  += from.msgs;
+		to.bytes += from.bytes;
+		to.min = std::min(to.min, from.min);
+		to.max = std::max(to.max, from.max);
+		to.sizes.merge(from.sizes);
+	};
+
+	for (const auto &m:other.msg_stats)
+	{
+		_mergeDirection(msg_stats[m.first].sent, m.second.sent);
+		_mergeDirection(msg_stats[m.first].recv, m.second.recv);
+	}
+
+	// other may continue this instance in time (e.g. the next time slice)
+	for (const auto &n:other.node_idle)
+		node_idle[n.first].merge(n.second);
+
+	for (const auto &p:other.p2p_stats)
+		for (const auto &r:p.second)
+			p2p_stats[p.first][r.first].merge(r.second);
+	p2p_total.merge(other.p2p_total);
+	p2p_negative += other.p2p_negative;
+
+	for (const auto &p:other.wait_states)
+		for (const auto &r:p.second)
+		{
+			auto &ws = wait_states[p.first][r.first];
+			ws.late_sender        += r.second.late_sender;
+			ws.late_sender_msgs   += r.second.late_sender_msgs;
+			ws.late_receiver      += r.second.late_receiver;
+			ws.late_receiver_msgs += r.second.late_receiver_msgs;
+		}
+	rma.merge(other.rma);
+
+	for (const auto &p:other.io_procs)
+		io_procs[p.first].merge(p.second);
+	for (const auto &f:other.io_files)
+		io_files[f.first].merge(f.second);
+
+	for (const auto &c:other.site_stats)
+	{
+		auto &ss = site_stats[c.first];
+		ss.calls      += c.second.calls;
+		ss.sent       += c.second.sent;
+		ss.sent_bytes += c.second.sent_bytes;
+		ss.recv       += c.second.recv;
+		ss.recv_bytes += c.second.recv_bytes;
+		ss.colls      += c.second.colls;
+		ss.coll_bytes += c.second.coll_bytes;
+	}
+
+	for (const auto &p:other.send_regions)
+		for (const auto &r:p.second)
+		{
+			auto &sr = send_regions[p.first][r.first];
+			sr.leave = std::max(sr.leave, r.second.leave);
+			sr.sends += r.second.sends;
+		}
+
+	for (const auto &p:other.fkt_stats)
+		for (const auto &f:p.second)
+		{
+			auto &fs = getFktStats(p.first, f.first);
+			fs.time  += f.second.time;
+			fs.excl  += f.second.excl;
+			fs.calls += f.second.calls;
+		}
+
+	// calls other left but did not enter are closed on our stacks,
+	// the calls other left open continue on top of them
+	for (const auto &p:other.call_stacks)
+	{
+		auto &stack = getCallStack(p.first);
+		const auto &o = p.second;
+
+		// the calls of other before each of its open leaves are made from
+		// the call open here at that point
+		std::vector<uint32_t> nodes;
+		auto graft = [&stack, &o, &nodes](size_t epoch)
+		{
+			const uint32_t b = o.tree.findBase(epoch);
+			if (b != CallTree::none)
+				stack.tree.graft(stack.frames.empty() ? stack.tree.base(stack.leaves.size()) : stack.frames.back().node, o.tree, b, nodes);
+		};
+
+		// outer calls of other below a call of the same function open here
+		// are inner ones, the others may still be below an earlier one
+		const uint32_t proc = p.first;
+		auto settle = [this, &stack, &o, proc](size_t epoch)
+		{
+			if (epoch >= o.outer_done.size())
+				return;
+			for (const auto &d:o.outer_done[epoch])
+			{
+				if (d.second == 0)
+					continue;
+				if (stack.open[d.first] > 0)
+					getFktStats(proc, d.first).time -= d.second;
+				else
+					outerDone(stack)[d.first] += d.second;
+			}
+		};
+
+		for (size_t k=0; k<o.leaves.size(); k++)
+		{
+			const auto &l = o.leaves[k];
+			graft(k);
+			settle(k);
+			if (stack.frames.empty())
+			{
+				stack.leaves.push_back({l.time, l.child + stack.base_child, l.func});
+				stack.base_child = 0;
+				continue;
+			}
+
+			stack.frames.back().child += l.child;
+			leaveCall(p.first, stack, l.func, l.time);
+		}
+		graft(o.leaves.size());
+		settle(o.leaves.size());
+
+		if (stack.frames.empty())
+			stack.base_child += o.base_child;
+		else
+			stack.frames.back().child += o.base_child;
+
+		for (auto f:o.frames)
+		{
+			if (stack.open[f.func]++ > 0)
+				f.outer = false;
+			if (f.node != CallTree::none)
+				f.node = nodes[f.node];
+			stack.frames.push_back(f);
+		}
+	}
+	unmatched_leaves += other.unmatched_leaves;
+
+	for (const auto &c:other.coll_stats)
+		for (const auto &o:c.second)
+		{
+			auto &cs = coll_stats[c.first][o.first];
+			cs.sent  += o.second.sent;
+			cs.recv  += o.second.recv;
+			cs.calls += o.second.calls;
+			cs.instances    += o.second.instances;
+			cs.time         += o.second.time;
+			cs.max_time      = std::max(cs.max_time, o.second.max_time);
+			cs.participants += o.second.participants;
+			cs.proc_time    += o.second.proc_time;
+			cs.wait         += o.second.wait;
+		}
+	for (const auto &w:other.coll_wait)
+		coll_wait[w.first] += w.second;
+
+	comm_p2p.merge(other.comm_p2p);
+	for (const auto &c:other.coll_bytes)
+		for (const auto &p:c.second)
+		{
+			auto &cb = coll_bytes[c.first][p.first];
+			cb.sent  += p.second.sent;
+			cb.recv  += p.second.recv;
+			cb.sends += p.second.sends;
+		}
+
+	for (const auto &p:other.papi_counter)
+	{
+		auto &to = papi_counter[p.first];
+		if (to.value.size() < p.second.value.size())
+		{
+			to.value.resize(p.second.value.size(), 0);
+			to.recorded.resize(p.second.value.size(), 0);
+		}
+
+		for (size_t i=0; i<p.second.value.size(); i++)
+			if (p.second.recorded[i])
+			{
+				to.value[i]    = p.second.value[i];
+				to.recorded[i] = 1;
+			}
+	}
+}
+
 void
 TraceStats::print(void)
 {
 	std::stringstream buf;
 
+	// event based analyses are not available in summary-only mode
+	const std::string skipped = "  skipped (no event records read in summary-only mode)\n";
+
+	// analyses turned off on the command line
+	auto _off = [](const std::string title, const std::string option)
+	{
+		return title + "\n===================================================\n  skipped (" + option + ")\n";
+	};
+
 	buf << "~~~~~~~~~~~~~~~~~~~~~~ Stats ~~~~~~~~~~~~~~~~~~~~~~" << '\n';
 
 	buf << "OTF Stats:" << '\n';
@@ -740,46 +2177,113 @@ TraceStats::print(void)
 	buf << map2table("Counters", counter_map);
 	buf << "\n";
 
-	buf << msgs2table("Message Statistics:", msg_stats);
-	buf << "\n";
+	if (config->messages)
+	{
+		buf << msgs2table("Message Statistics:", msg_stats);
+		buf << "\n";
+
+		buf << p2p2table("Message Matching:");
+		buf << "\n";
+	}
+	else
+	{
+		buf << _off("Message Statistics:", "--no-messages");
+		buf << "\n";
+
+		buf << _off("Message Matching:", "--no-messages");
+		buf << "\n";
+	}
+
+	if (config->wait_states)
+	{
+		buf << wait2table("Wait States:");
+		buf << "\n";
+	}
+
+	if (config->call_sites > 0)
+	{
+		buf << sites2table("Call Sites:");
+		buf << "\n";
+	}
+
+	if (config->rma)
+	{
+		buf << rma2table("RMA Statistics:");
+		buf << "\n";
+	}
+
+	if (config->file_io)
+	{
+		buf << io2table("File I/O:");
+		buf << "\n";
+	}
+
+	if (config->comm_matrix)
+	{
+		buf << matrix2table("Communication Matrix:");
+		buf << "\n";
+	}
 
 	buf << map2table("Function Groups", function_group_map);
 	buf << map2table("Functions", function_map);
 	buf << "\n";
 
-	buf << fkts2table("Function Statistics:", fkt_stats);
+	if (config->functions)
+		buf << fkts2table("Function Statistics:", fkt_stats);
+	else
+		buf << _off("Function Statistics:", "--no-functions");
 	buf << "\n";
 
-	buf << coll2table("Collective Statistics:", coll_stats);
+	if (config->collectives)
+		buf << coll2table("Collective Statistics:", coll_stats);
+	else
+		buf << _off("Collective Statistics:", "--no-collectives");
 	buf << "\n";
 
 	buf << "PAPI/Performance Counter Stats:\n";
 	buf << "===================================================" << '\n';
-	std::map<std::string, uint64_t> total;
-	for (auto p:papi_counter)
+	if (config->summary_only)
 	{
-		auto proc = p.first;
-		buf << "Process " << proc << ":\n";
-		buf << "---------------------------------------------------" << '\n';
-
-		for (auto c:p.second)
+		buf << skipped;
+	}
+	else if (!config->functions)
+	{
+		buf << "  skipped (--no-functions)\n";
+	}
+	else
+	{
+		std::map<std::string, uint64_t> total;
+		for (const auto &p:papi_counter)
 		{
-			buf.precision(3);
-			buf << std::scientific << std::setw(16) << c.first << "   " << static_cast<double>(c.second) << std::endl;
+			auto proc = p.first;
+			buf << "Process " << proc << ":\n";
+			buf << "---------------------------------------------------" << '\n';
+
+			// by counter name
+			std::map<std::string, uint64_t> named;
+			for (size_t i=0; i<p.second.value.size(); i++)
+				if (p.second.recorded[i])
+					named[papi_names[i]] = p.second.value[i];
+
+			for (auto c:named)
+			{
+				buf.precision(3);
+				buf << std::scientific << std::setw(16) << c.first << "   " << static_cast<double>(c.second) << std::endl;
 
-			total[c.first] += c.second;
+				total[c.first] += c.second;
 
-			metrics.papi.push_back(p.second);
+				metrics.papi.push_back(named);
+			}
+			buf << '\n';
 		}
-		buf << '\n';
-	}
 
-	buf << "All Processes:" << "\n";
-	buf << "---------------------------------------------------" << '\n';
-	for (auto c:total)
-	{
-		buf.precision(3);
-		buf << std::scientific << std::setw(16) << c.first << "   " << static_cast<double>(c.second) << std::endl;
+		buf << "All Processes:" << "\n";
+		buf << "---------------------------------------------------" << '\n';
+		for (auto c:total)
+		{
+			buf.precision(3);
+			buf << std::scientific << std::setw(16) << c.first << "   " << static_cast<double>(c.second) << std::endl;
+		}
 	}
 	buf << '\n';
 
@@ -788,133 +2292,189 @@ TraceStats::print(void)
 
 	buf << "Verbosity:" << '\n';
 	buf << "---------------------------------------------------" << '\n';
-	std::vector<double> verbosity_all;
-	for (auto p:process_map)
+	if (config->summary_only)
 	{
-		auto proc = p.first;
-		auto bytes = getBytesSent(proc) + getBytesRecv(proc);
-		auto flops = getFlops(proc);
-
-		buf << "P" << proc << ": ";
-		if (flops == 0 || bytes == 0)
-		{
-			char b[4096];
-			sprintf(b, "No flops or bytes recorded (f=%lu, b=%lu)", flops, bytes);
-			buf << b << '\n';
-			verbosity_all.push_back(0.0);
-		}
-		else
+		buf << skipped;
+	}
+	else if (!config->messages || !config->functions)
+	{
+		buf << "  skipped (" << (config->messages ? "--no-functions" : "--no-messages") << ")\n";
+	}
+	else
+	{
+		std::vector<double> verbosity_all;
+		for (auto p:process_map)
 		{
-			auto verbosity_node = (double)bytes / (double)flops;
-			buf << verbosity_node << " Bytes/Flop" << '\n';
-			verbosity_all.push_back(verbosity_node);
+			auto proc = p.first;
+			auto bytes = getBytesSent(proc) + getBytesRecv(proc);
+			auto flops = getFlops(proc);
+
+			buf << "P" << proc << ": ";
+			if (flops == 0 || bytes == 0)
+			{
+				char b[4096];
+				sprintf(b, "No flops or bytes recorded (f=%lu, b=%lu)", flops, bytes);
+				buf << b << '\n';
+				verbosity_all.push_back(0.0);
+			}
+			else
+			{
+				auto verbosity_node = (double)bytes / (double)flops;
+				buf << verbosity_node << " Bytes/Flop" << '\n';
+				verbosity_all.push_back(verbosity_node);
 
-			metrics.verbosity.push_back(verbosity_node);
+				metrics.verbosity.push_back(verbosity_node);
+			}
 		}
+		buf << "--------------------------" << '\n';
+		buf << "Global Average: " << average(verbosity_all) << " Bytes/Flop" << '\n';
 	}
-	buf << "--------------------------" << '\n';
-	buf << "Global Average: " << average(verbosity_all) << " Bytes/Flop" << '\n';
 	buf << '\n';
 
 
 	buf << "Messages Rate:" << '\n';
 	buf << "---------------------------------------------------" << '\n';
-	std::vector<double> messagerate_all;
-	for (auto p:process_map)
+	if (!config->messages)
 	{
-		auto proc = p.first;
-		double n = getNumSent(proc);
-		double t = getApplicationTime();
-
-		buf << "P" << proc << ": ";
-		if (n > 0)
-		{
-			auto mrate = n/t;
-			buf << mrate << " Msgs/s" << '\n';
-			messagerate_all.push_back(mrate);
-
-			metrics.msgrate.push_back(mrate);
-			metrics.msg_tx.push_back(getNumSent(proc));
-			metrics.msg_rx.push_back(getNumRecv(proc));
-			metrics.bytes_tx.push_back(getBytesSent(proc));
-			metrics.bytes_rx.push_back(getBytesRecv(proc));
-		}
-		else
+		buf << "  skipped (--no-messages)\n";
+	}
+	else
+	{
+		std::vector<double> messagerate_all;
+		for (auto p:process_map)
 		{
-			buf << "No messages recorded." << '\n';
-			messagerate_all.push_back(0.0);
+			auto proc = p.first;
+			double n = getNumSent(proc);
+			double t = getApplicationTime();
+
+			buf << "P" << proc << ": ";
+			if (n > 0)
+			{
+				auto mrate = n/t;
+				buf << mrate << " Msgs/s" << '\n';
+				messagerate_all.push_back(mrate);
+
+				metrics.msgrate.push_back(mrate);
+				metrics.msg_tx.push_back(getNumSent(proc));
+				metrics.msg_rx.push_back(getNumRecv(proc));
+				metrics.bytes_tx.push_back(getBytesSent(proc));
+				metrics.bytes_rx.push_back(getBytesRecv(proc));
+			}
+			else
+			{
+				buf << "No messages recorded." << '\n';
+				messagerate_all.push_back(0.0);
+			}
 		}
+		buf << "--------------------------" << '\n';
+		buf << "Global Average: " << average(messagerate_all) << " Messages/s" << '\n';
 	}
-	buf << "--------------------------" << '\n';
-	buf << "Global Average: " << average(messagerate_all) << " Messages/s" << '\n';
 	buf << '\n';
 
 
 	buf << "MPI Idle Time" << '\n';
 	buf << "---------------------------------------------------" << '\n';
-	std::map<std::string, std::vector<double>> idle_all;
-	buf << "# process min max avg tot percent" << '\n';
-	for (auto p:node_idle)
-	{
-		auto proc = p.first;
-		//auto min = static_cast<double>(p.second.getMin()/1e9);
-		//auto max = static_cast<double>(p.second.getMax()/1e9);
-		//auto avg = static_cast<double>(p.second.getAvg()/1e9);
-		//auto tot = static_cast<double>(p.second.getTot()/1e9);
-		auto min = toNanoS(p.second.getMin());
-		auto max = toNanoS(p.second.getMax());
-		auto avg = toNanoS(p.second.getAvg());
-		auto tot = toNanoS(p.second.getTot());
-		auto percent = p.second.getTot() / getApplicationTime();
-
-		buf << "P" << proc << ": " << min << " " << max << " " << avg << " " << tot << " " << percent << '\n';
-
-		idle_all["min"].push_back(min);
-		idle_all["max"].push_back(max);
-		idle_all["avg"].push_back(avg);
-		idle_all["tot"].push_back(tot);
-		idle_all["percent"].push_back(percent);
-
-		metrics.mpi_idle_min.push_back(min);
-		metrics.mpi_idle_max.push_back(max);
-		metrics.mpi_idle_avg.push_back(avg);
-		metrics.mpi_idle_tot.push_back(tot);
-		metrics.mpi_idle_tot.push_back(percent);
-	}
-	buf << "--------------------------" << '\n';
-	buf << "Global Average Min     : " << average(idle_all["min"]) << " s idle" << '\n';
-	buf << "Global Average Max     : " << average(idle_all["max"]) << " s idle" << '\n';
-	buf << "Global Average Average : " << average(idle_all["avg"]) << " s idle" << '\n';
-	buf << "Global Average Total   : " << average(idle_all["tot"]) << " s idle" << '\n';
-	buf << "Global Average Percent : " << average(idle_all["percent"]) << " % idle" << '\n';
+	if (config->summary_only)
+	{
+		buf << skipped;
+	}
+	else if (!config->messages)
+	{
+		buf << "  skipped (--no-messages)\n";
+	}
+	else
+	{
+		std::map<std::string, std::vector<double>> idle_all;
+		buf << "# process min max avg tot percent std p50 p95 p99" << '\n';
+		for (auto p:node_idle)
+		{
+			auto proc = p.first;
+			//auto min = static_cast<double>(p.second.getMin()/1e9);
+			//auto max = static_cast<double>(p.second.getMax()/1e9);
+			//auto avg = static_cast<double>(p.second.getAvg()/1e9);
+			//auto tot = static_cast<double>(p.second.getTot()/1e9);
+			auto min = toNanoS(p.second.getMin());
+			auto max = toNanoS(p.second.getMax());
+			auto avg = toNanoS(p.second.getAvg());
+			auto tot = toNanoS(p.second.getTot());
+			auto percent = p.second.getTot() / getApplicationTime();
+			auto stddev = toNanoS(p.second.getStdDev());
+			auto p50 = toNanoS(p.second.getQuantile(0.50));
+			auto p95 = toNanoS(p.second.getQuantile(0.95));
+			auto p99 = toNanoS(p.second.getQuantile(0.99));
+
+			buf << "P" << proc << ": " << min << " " << max << " " << avg << " " << tot << " " << percent
+				<< " " << stddev << " " << p50 << " " << p95 << " " << p99 << '\n';
+
+			idle_all["min"].push_back(min);
+			idle_all["max"].push_back(max);
+			idle_all["avg"].push_back(avg);
+			idle_all["tot"].push_back(tot);
+			idle_all["percent"].push_back(percent);
+			idle_all["std"].push_back(stddev);
+			idle_all["p50"].push_back(p50);
+			idle_all["p95"].push_back(p95);
+			idle_all["p99"].push_back(p99);
+
+			metrics.mpi_idle_min.push_back(min);
+			metrics.mpi_idle_max.push_back(max);
+			metrics.mpi_idle_avg.push_back(avg);
+			metrics.mpi_idle_p50.push_back(p50);
+			metrics.mpi_idle_p95.push_back(p95);
+			metrics.mpi_idle_p99.push_back(p99);
+			metrics.mpi_idle_tot.push_back(tot);
+			metrics.mpi_idle_tot.push_back(percent);
+		}
+		buf << "--------------------------" << '\n';
+		buf << "Global Average Min     : " << average(idle_all["min"]) << " s idle" << '\n';
+		buf << "Global Average Max     : " << average(idle_all["max"]) << " s idle" << '\n';
+		buf << "Global Average Average : " << average(idle_all["avg"]) << " s idle" << '\n';
+		buf << "Global Average Total   : " << average(idle_all["tot"]) << " s idle" << '\n';
+		buf << "Global Average Percent : " << average(idle_all["percent"]) << " % idle" << '\n';
+		buf << "Global Average StdDev  : " << average(idle_all["std"]) << " s idle" << '\n';
+		buf << "Global Average P50     : " << average(idle_all["p50"]) << " s idle" << '\n';
+		buf << "Global Average P95     : " << average(idle_all["p95"]) << " s idle" << '\n';
+		buf << "Global Average P99     : " << average(idle_all["p99"]) << " s idle" << '\n';
+	}
 	buf << '\n';
 
 
 	buf << "Performance:" << '\n';
 	buf << "---------------------------------------------------" << '\n';
-	std::vector<double> perf_all;
-	for (auto p:process_map)
+	if (config->summary_only)
 	{
-		auto proc = p.first;
-		double flops = getFlops(proc);
-		double time = getApplicationTime();
-
-		buf << "P" << proc << ": ";
-		if (flops > 0)
-		{
-			auto fps = flops/time;
-			buf << fps  << " Flops/s" << '\n';
-			perf_all.push_back(fps);
-		}
-		else
+		buf << skipped;
+	}
+	else if (!config->functions)
+	{
+		buf << "  skipped (--no-functions)\n";
+	}
+	else
+	{
+		std::vector<double> perf_all;
+		for (auto p:process_map)
 		{
-			buf << "No flops recorded." << '\n';
-			perf_all.push_back(0.0);
+			auto proc = p.first;
+			double flops = getFlops(proc);
+			double time = getApplicationTime();
+
+			buf << "P" << proc << ": ";
+			if (flops > 0)
+			{
+				auto fps = flops/time;
+				buf << fps  << " Flops/s" << '\n';
+				perf_all.push_back(fps);
+			}
+			else
+			{
+				buf << "No flops recorded." << '\n';
+				perf_all.push_back(0.0);
+			}
 		}
+		buf << "--------------------------" << '\n';
+		buf << "Global Average: " << average(perf_all) << " Flops/s" << '\n';
+		buf << "Global Total  : " << std::accumulate(perf_all.begin(), perf_all.end(), 0.0) << " Flops/s" << '\n';
 	}
-	buf << "--------------------------" << '\n';
-	buf << "Global Average: " << average(perf_all) << " Flops/s" << '\n';
-	buf << "Global Total  : " << std::accumulate(perf_all.begin(), perf_all.end(), 0.0) << " Flops/s" << '\n';
 	buf << '\n';
 
 	buf << "Note: Metrics with respect to time may be inaccurate due to the tracing overhead!" << '\n';
@@ -930,6 +2490,9 @@ TraceStats::print(void)
 		"MPI_idle_min" + sep +
 		"MPI_idle_max" + sep +
 		"MPI_idle_avg" + sep +
+		"MPI_idle_p50" + sep +
+		"MPI_idle_p95" + sep +
+		"MPI_idle_p99" + sep +
 		"TX_Messages" + sep +
 		"RX_Messages" + sep +
 		"TX_Bytes" + sep +
@@ -945,15 +2508,18 @@ TraceStats::print(void)
 	for (uint32_t i=0; i<getNumProcesses(); i++)
 	{
 		aggr_nodes << i << sep;
-		aggr_nodes << metrics.verbosity.at(i) << sep;
-		aggr_nodes << metrics.msgrate.at(i) << sep;
-		aggr_nodes << metrics.mpi_idle_min.at(i) << sep;
-		aggr_nodes << metrics.mpi_idle_max.at(i) << sep;
-		aggr_nodes << metrics.mpi_idle_avg.at(i) << sep;
-		aggr_nodes << metrics.msg_tx.at(i) << sep;
-		aggr_nodes << metrics.msg_rx.at(i) << sep;
-		aggr_nodes << metrics.bytes_tx.at(i) << sep;
-		aggr_nodes << metrics.bytes_rx.at(i);
+		csvValue(aggr_nodes, metrics.verbosity, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.msgrate, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.mpi_idle_min, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.mpi_idle_max, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.mpi_idle_avg, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.mpi_idle_p50, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.mpi_idle_p95, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.mpi_idle_p99, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.msg_tx, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.msg_rx, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.bytes_tx, i); aggr_nodes << sep;
+		csvValue(aggr_nodes, metrics.bytes_rx, i);
 		//aggr_nodes << metrics.papi.at(i)["PAPI_TOT_CYC"] << sep;
 		//aggr_nodes << metrics.papi.at(i)["PAPI_TOT_INS"] << sep;
 		//aggr_nodes << metrics.papi.at(i)["PAPI_FP_INS"] << sep;
@@ -967,20 +2533,38 @@ TraceStats::print(void)
 	aggr_avg << header;
 	{
 		aggr_avg << -1 << sep;
-		aggr_avg << average(metrics.verbosity) << sep;
-		aggr_avg << average(metrics.msgrate) << sep;
-		aggr_avg << average(metrics.mpi_idle_min) << sep;
-		aggr_avg << average(metrics.mpi_idle_max) << sep;
-		aggr_avg << average(metrics.mpi_idle_avg) << sep;
-		aggr_avg << average(metrics.msg_tx) << sep;
-		aggr_avg << average(metrics.msg_rx) << sep;
-		aggr_avg << average(metrics.bytes_tx) << sep;
-		aggr_avg << average(metrics.bytes_rx);
+		csvAverage(aggr_avg, metrics.verbosity); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.msgrate); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.mpi_idle_min); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.mpi_idle_max); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.mpi_idle_avg); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.mpi_idle_p50); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.mpi_idle_p95); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.mpi_idle_p99); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.msg_tx); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.msg_rx); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.bytes_tx); aggr_avg << sep;
+		csvAverage(aggr_avg, metrics.bytes_rx);
 		// TODO: PAPI avg
 	}
 	aggr_avg << std::endl;
 	aggr_avg.close();
 
+	if (config->messages && !config->summary_only)
+		writeP2PPairs();
+	if (config->wait_states && !config->summary_only)
+		writeWaitStates();
+	if (config->call_sites > 0 && !config->summary_only)
+		writeCallSites();
+	if (config->rma && !config->summary_only)
+		writeRma();
+	if (config->file_io && !config->summary_only)
+		writeFileIo();
+	if (config->cct && !config->summary_only)
+		writeCallTrees();
+	if (config->comm_matrix && !config->summary_only)
+		writeCommMatrix();
+
 	// write stats to screen
 	if (config->stats_toscreen)
 		std::cout << buf.str() << std::endl;
@@ -1025,16 +2609,19 @@ TraceStats::validate(const bool printErrors)
 	}
 
 	// check for equal number of entrys/exits for each function
-	for (const auto m1:fkt_stats)
-		for (const auto m2:m1.second)
-			for (const auto m3:m2.second)
-			{
-				if (m3.second.enter != std::numeric_limits<uint64_t>::max())
-					if (printErrors)
-						std::cout	<< "Warning: unbalanced function entry/exit ratio.\n"
-									<< "  f_id=" << m2.first << " (" << getFunctionName(m2.first) << ")"
-									<< std::endl;
-			}
+	uint64_t open_leaves = unmatched_leaves;
+	for (const auto &s:call_stacks)
+	{
+		open_leaves += s.second.leaves.size();
+		for (const auto &f:s.second.frames)
+			if (printErrors)
+				std::cout	<< "Warning: unbalanced function entry/exit ratio.\n"
+							<< "  p=" << s.first << " f_id=" << f.func << " (" << getFunctionName(f.func) << ")"
+							<< std::endl;
+	}
+
+	if (open_leaves > 0 && printErrors)
+		std::cout << "Warning: " << open_leaves << " function exits without entry." << std::endl;
 
 	return error;
 }
@@ -1,9 +1,33 @@
 #include <trace_visualizer.h>
+#include <otf.h>
 
-TraceVisualizer::TraceVisualizer(std::shared_ptr<Config> cfg, std::shared_ptr<TraceStats> ts) :
+TraceVisualizer::TraceVisualizer(std::shared_ptr<Config> cfg, std::shared_ptr<TraceStats> ts, bool shard) :
+	is_shard(shard),
 	config(cfg),
-	stats(ts)
+	stats(ts),
+	injections(ts->getProcessIndex()),
+	injection_bins(ts->getProcessIndex()),
+	inactivity(ts->getProcessIndex()),
+	inactivity_periods(ts->getProcessIndex()),
+	counter_series(ts->getProcessIndex()),
+	io_bins(ts->getProcessIndex()),
+	messages_cdf(ts->getProcessIndex())
 {
+	// edges of the inactivity histogram bins, log bins start at 1 ns
+	const uint32_t bins = config->iahist_bins;
+	const double max = config->iahist_max * 1e3;
+	for (uint32_t i=0; i<=bins; i++)
+	{
+		if (config->iahist_log)
+			inactivity_edges.push_back(std::llround(std::pow(max, double(i) / bins)));
+		else
+			inactivity_edges.push_back(std::llround(max * i / bins));
+	}
+
+	// shards only collect data, the plots are made by the instance they are merged into
+	if (is_shard)
+		return;
+
 	// check for gnuplot utility
 	if (std::system("which gnuplot > /dev/null"))
 		std::cout << "Warning: gnuplot not found, no graphs will be printed!" << std::endl;
@@ -23,53 +47,342 @@ TraceVisualizer::TraceVisualizer(std::shared_ptr<Config> cfg, std::shared_ptr<Tr
 
 TraceVisualizer::~TraceVisualizer()
 {
-	makeInjPlot(config->resdir);
-	makeCdfPlot(config->resdir);
-	makeInactivityHistogram(config->resdir);
+	if (config->summary_only && !is_shard)
+	{
+		std::cout << "Skipped injection, CDF, inactivity and counter plots (summary-only mode)" << std::endl;
+	}
+	else if (!is_shard)
+	{
+		if (config->plots)
+		{
+			makeInjPlot(config->resdir);
+			makeCdfPlot(config->resdir);
+		}
+		if (config->messages)
+			makeInactivityHistogram(config->resdir);
+		makeCounterPlot(config->resdir);
+		if (config->file_io)
+			makeIoPlot(config->resdir);
+		if (config->comm_matrix)
+			makeCommMatrixPlot(config->resdir);
+	}
 
 #ifdef DEBUG
 	dtor_msg(__PRETTY_FUNCTION__);
 #endif
 }
 
-void TraceVisualizer::addSendP2P(uint32_t proc, uint64_t time, uint64_t bytes)
+bool TraceVisualizer::needsTimeOrder(void) const
+{
+	/* injections and inactivity periods are recorded per process */
+	return false;
+}
+
+void TraceVisualizer::merge(const TraceVisualizer &other)
+{
+	/*
+	 * Appends the data of another instance (a shard of a parallel run).
+	 * For processes present in both, other has to hold the later events.
+	 */
+
+	for (const auto &p:other.injections)
+		for (const auto &d:p.second)
+		{
+			auto &v = injections[p.first][d.first];
+			v.insert(v.end(), d.second.begin(), d.second.end());
+		}
+
+	for (const auto &p:other.injection_bins)
+		for (const auto &d:p.second)
+		{
+			auto &v = injection_bins[p.first][d.first];
+			if (v.empty())
+			{
+				v = d.second;
+				continue;
+			}
+
+			for (size_t i=0; i<v.size(); i++)
+			{
+				v[i].count += d.second[i].count;
+				v[i].bytes += d.second[i].bytes;
+				v[i].min = std::min(v[i].min, d.second[i].min);
+				v[i].max = std::max(v[i].max, d.second[i].max);
+			}
+		}
+
+	for (const auto &p:other.io_bins)
+		for (const auto &d:p.second)
+		{
+			auto &v = io_bins[p.first][d.first];
+			if (v.empty())
+			{
+				v = d.second;
+				continue;
+			}
+
+			for (size_t i=0; i<v.size(); i++)
+			{
+				v[i].count += d.second[i].count;
+				v[i].bytes += d.second[i].bytes;
+				v[i].min = std::min(v[i].min, d.second[i].min);
+				v[i].max = std::max(v[i].max, d.second[i].max);
+			}
+		}
+
+	for (const auto &p:other.inactivity)
+	{
+		auto &v = inactivity[p.first];
+		if (v.empty())
+			v = p.second;
+		else
+			for (size_t i=0; i<v.size(); i++)
+				v[i] += p.second[i];
+	}
+
+	for (const auto &p:other.inactivity_periods)
+	{
+		auto &v = inactivity_periods[p.first];
+		v.insert(v.end(), p.second.begin(), p.second.end());
+	}
+
+	for (const auto &p:other.counter_series)
+	{
+		auto &series = counter_series[p.first];
+		if (series.size() < p.second.size())
+			series.resize(p.second.size());
+
+		for (size_t i=0; i<p.second.size(); i++)
+		{
+			auto &cs = series[i];
+			const auto &o = p.second[i];
+			if (!o.active)
+				continue;
+
+			if (!cs.active)
+			{
+				cs = o;
+				continue;
+			}
+
+			// the first sample of other continues our last one
+			addCounterRate(cs, o.first_time, o.first_value);
+
+			if (cs.bins.empty())
+				cs.bins = o.bins;
+			else
+				for (size_t b=0; b<o.bins.size(); b++)
+				{
+					cs.bins[b].samples += o.bins[b].samples;
+					cs.bins[b].delta   += o.bins[b].delta;
+					cs.bins[b].ticks   += o.bins[b].ticks;
+					cs.bins[b].min = std::min(cs.bins[b].min, o.bins[b].min);
+					cs.bins[b].max = std::max(cs.bins[b].max, o.bins[b].max);
+				}
+
+			cs.last_time  = o.last_time;
+			cs.last_value = o.last_value;
+		}
+	}
+
+	for (const auto &p:other.messages_cdf)
+		for (const auto &t:p.second)
+			messages_cdf[p.first][t.first].merge(t.second);
+
+	for (const auto &t:other.messages_cdf_allnodes)
+		messages_cdf_allnodes[t.first].merge(t.second);
+}
+
+void TraceVisualizer::addInjection(std::vector<InjBin> &bins, uint64_t time, uint64_t bytes)
+{
+	if (bins.empty())
+		bins.resize(config->inj_bins);
+
+	// bins split the application runtime, late timestamps end up in the last one
+	const double rel = stats->getRelativeTime(time) * bins.size();
+	const size_t idx = rel < bins.size() ? static_cast<size_t>(rel) : bins.size()-1;
+
+	auto &bin = bins[idx];
+	bin.count++;
+	bin.bytes += bytes;
+	bin.min = std::min(bin.min, bytes);
+	bin.max = std::max(bin.max, bytes);
+}
+
+void TraceVisualizer::addSendBatch(uint32_t proc, const MessageBatch::P2P &batch)
 {
-	auto time_abs = stats->getAbsoluteTime(time);
-	auto time_rel = stats->getRelativeTime(time);
-	injections[proc][P2P_SEND].push_back({time_abs, time_rel, bytes});
+	auto &cdf = messages_cdf[proc][P2P];
+	auto &all = messages_cdf_allnodes[P2P];
+
+	if (config->inj_bins)
+	{
+		auto &bins = injection_bins[proc][P2P_SEND];
+		for (size_t i=0; i<batch.time.size(); i++)
+			addInjection(bins, batch.time[i], batch.length[i]);
+	}
+	else
+	{
+		auto &inj = injections[proc][P2P_SEND];
+		for (size_t i=0; i<batch.time.size(); i++)
+			inj.push_back({stats->getAbsoluteTime(batch.time[i]), stats->getRelativeTime(batch.time[i]), batch.length[i]});
+	}
+
+	if (cdf.empty())
+		cdf = SizeHistogram(config->exact_sizes);
+	if (all.empty())
+		all = SizeHistogram(config->exact_sizes);
+
+	for (auto len:batch.length)
+	{
+		cdf.add(len);
+		all.add(len);
+	}
+}
+
+void TraceVisualizer::addRecvBatch(uint32_t proc, const MessageBatch::P2P &batch)
+{
+	if (config->inj_bins)
+	{
+		auto &bins = injection_bins[proc][P2P_RECV];
+		for (size_t i=0; i<batch.time.size(); i++)
+			addInjection(bins, batch.time[i], batch.length[i]);
+		return;
+	}
+
+	auto &inj = injections[proc][P2P_RECV];
+	for (size_t i=0; i<batch.time.size(); i++)
+		inj.push_back({stats->getAbsoluteTime(batch.time[i]), stats->getRelativeTime(batch.time[i]), batch.length[i]});
+}
+
+void TraceVisualizer::addCollBatch(uint32_t proc, const MessageBatch::Collective &batch)
+{
+	auto &cdf = messages_cdf[proc][COLL];
+	auto &all = messages_cdf_allnodes[COLL];
+
+	if (config->inj_bins)
+	{
+		auto &bins_sent = injection_bins[proc][COLL_SEND];
+		auto &bins_recv = injection_bins[proc][COLL_RECV];
+		for (size_t i=0; i<batch.time.size(); i++)
+		{
+			addInjection(bins_sent, batch.time[i], batch.sent[i]);
+			addInjection(bins_recv, batch.time[i], batch.recv[i]);
+		}
+	}
+	else
+	{
+		auto &inj_sent = injections[proc][COLL_SEND];
+		auto &inj_recv = injections[proc][COLL_RECV];
+		for (size_t i=0; i<batch.time.size(); i++)
+		{
+			const auto time_abs = stats->getAbsoluteTime(batch.time[i]);
+			const auto time_rel = stats->getRelativeTime(batch.time[i]);
+			inj_sent.push_back({time_abs, time_rel, batch.sent[i]});
+			inj_recv.push_back({time_abs, time_rel, batch.recv[i]});
+		}
+	}
+
+	if (cdf.empty())
+		cdf = SizeHistogram(config->exact_sizes);
+	if (all.empty())
+		all = SizeHistogram(config->exact_sizes);
 
-	updateInactPeriods(proc, time);
+	for (auto sent:batch.sent)
+	{
+		cdf.add(sent);
+		all.add(sent);
+	}
+}
+
+void TraceVisualizer::addMessageBatch(uint32_t proc, const MessageBatch &batch)
+{
+	if (batch.size() == 0)
+		return;
+
+	if (!batch.send.time.empty())
+		addSendBatch(proc, batch.send);
+	if (!batch.recv.time.empty())
+		addRecvBatch(proc, batch.recv);
+	if (!batch.coll.time.empty())
+		addCollBatch(proc, batch.coll);
 }
 
-void TraceVisualizer::addRecvP2P(uint32_t proc, uint64_t time, uint64_t bytes)
+void TraceVisualizer::addInactivityGaps(uint32_t proc, const ActivityTracker::Gaps &gaps)
 {
-	auto time_abs = stats->getAbsoluteTime(time);
-	auto time_rel = stats->getRelativeTime(time);
-	injections[proc][P2P_RECV].push_back({time_abs, time_rel, bytes});
+	auto &hist = inactivity[proc];
+	if (hist.empty())
+		hist.resize(inactivity_edges.size() + 1, 0);
+
+	for (auto period:gaps.gap)
+		hist[inactivityBin(period)]++;
 
-	updateInactPeriods(proc, time);
+	if (config->iahist_raw)
+	{
+		auto &raw = inactivity_periods[proc];
+		raw.insert(raw.end(), gaps.gap.begin(), gaps.gap.end());
+	}
 }
 
-void TraceVisualizer::addColl(uint32_t proc, uint64_t time, uint64_t sent, uint64_t recv)
+void TraceVisualizer::addCounterSample(uint32_t proc, uint32_t slot, uint64_t time, uint64_t value)
 {
-	auto time_abs = stats->getAbsoluteTime(time);
-	auto time_rel = stats->getRelativeTime(time);
-	injections[proc][COLL_SEND].push_back({time_abs, time_rel, sent});
-	injections[proc][COLL_RECV].push_back({time_abs, time_rel, recv});
+	if (config->ctr_bins == 0)
+		return;
+
+	auto &series = counter_series[proc];
+	if (slot >= series.size())
+		series.resize(slot+1);
+
+	auto &cs = series[slot];
+	if (!cs.active)
+	{
+		cs.first_time  = cs.last_time  = time;
+		cs.first_value = cs.last_value = value;
+		cs.active = true;
+		return;
+	}
 
-	updateInactPeriods(proc, time);
+	addCounterRate(cs, time, value);
 }
 
-void TraceVisualizer::addMessageCDF_P2P(uint32_t proc, uint64_t msg_len)
+void TraceVisualizer::addCounterRate(CounterSeries &cs, uint64_t time, uint64_t value)
 {
-	messages_cdf[proc][P2P][msg_len]++;
-	messages_cdf_allnodes[P2P][msg_len]++;
+	// a reset counter starts over, a sample at the same time is combined with the next one
+	if (value < cs.last_value)
+	{
+		cs.last_time  = time;
+		cs.last_value = value;
+		return;
+	}
+	if (time <= cs.last_time)
+		return;
+
+	if (cs.bins.empty())
+		cs.bins.resize(config->ctr_bins);
+
+	// bins split the application runtime like the injection bins
+	const double rel = stats->getRelativeTime(time) * cs.bins.size();
+	const size_t idx = rel < cs.bins.size() ? static_cast<size_t>(rel) : cs.bins.size()-1;
+
+	const uint64_t delta = value - cs.last_value;
+	const uint64_t ticks = time - cs.last_time;
+	const double   rate  = delta / stats->getAbsoluteTime(ticks);
+
+	auto &bin = cs.bins[idx];
+	bin.samples++;
+	bin.delta += delta;
+	bin.ticks += ticks;
+	bin.min = std::min(bin.min, rate);
+	bin.max = std::max(bin.max, rate);
+
+	cs.last_time  = time;
+	cs.last_value = value;
 }
 
-void TraceVisualizer::addMessageCDF_COLL(uint32_t proc, uint64_t msg_len)
+uint32_t TraceVisualizer::inactivityBin(uint64_t period) const
 {
-	messages_cdf[proc][COLL][msg_len]++;
-	messages_cdf_allnodes[COLL][msg_len]++;
+	// index of the first edge above the period: 0 below the range, bins+1 beyond
+	const uint64_t ns = stats->toNanoS(period);
+	return std::upper_bound(inactivity_edges.begin(), inactivity_edges.end(), ns) - inactivity_edges.begin();
 }
 
 void TraceVisualizer::makeInjPlot(std::string dirname)
@@ -80,50 +393,42 @@ void TraceVisualizer::makeInjPlot(std::string dirname)
 	type[COLL_SEND] = "Coll. Send";
 	type[COLL_RECV] = "Coll. Recv";
 
-	const auto& sep = gnuplot_seperator;
+	// one file per process with a data section per direction
+	std::vector<uint32_t> procs;
+	if (config->inj_bins)
+		for (const auto &x:injection_bins)
+			procs.push_back(x.first);
+	else
+		for (const auto &x:injections)
+			procs.push_back(x.first);
 
-	for (auto x:injections)
+	for (auto proc:procs)
 	{
-		auto proc = x.first;
 		std::stringstream filename;
 		filename << dirname << "/" << gnuplot_inj_filename_prefix << std::setw(procEnumFill) << std::setfill('0') << proc << ".csv";
 		std::ofstream out(filename.str(), std::ofstream::out);
 
-		// set dummy values for gnuplot script
-		if (x.second[COLL_SEND].empty())
-			x.second[COLL_SEND].push_back({0.0, 0.0, 0});
-
-		if (x.second[COLL_RECV].empty())
-			x.second[COLL_RECV].push_back({0.0, 0.0, 0});
-
-		if (x.second[P2P_SEND].empty())
-			x.second[P2P_SEND].push_back({0.0, 0.0, 0});
-
-		if (x.second[P2P_RECV].empty())
-			x.second[P2P_RECV].push_back({0.0, 0.0, 0});
-
-		for (auto y:x.second)
+		for (auto dir:{P2P_SEND, P2P_RECV, COLL_SEND, COLL_RECV})
 		{
 			// section header
-			auto dir = y.first;
 			out << "\"" << type[dir] << "\"" << '\n';
 			out << "# trace=" << config->tracename << ", node=" << proc << '\n';
-			out << "# time_absolute" << sep << "time_relative" << sep << "bytes" << "\n";
 
-			// data
-			for (auto z:y.second)
-			{
-				out << z.time_absolute << sep << z.time_relative << sep << z.bytes << "\n";
-			}
+			if (config->inj_bins)
+				writeInjBins(out, injection_bins[proc][dir]);
+			else
+				writeInjData(out, injections[proc][dir]);
 
 			// next data section
 			out << "\n\n";
 		}
 
 		out.close();
-		filename.str(std::string()); // clear stringstream
 	}
 
+	// binned data: mean message size per bin with the min/max range as error bars
+	const std::string columns = config->inj_bins ? "1:($4/$3):5:6 w yerrorbars" : "1:3 w points";
+
 	std::string gnuplot_scriptfile = "plot_inj.gnuplot";
 	if (config->verbose)
 		std::cout << "Writing Gnuplot Script ... " << std::flush;
@@ -154,10 +459,10 @@ void TraceVisualizer::makeInjPlot(std::string dirname)
 		<< "\tset output sprintf('%s.png', file)" << '\n'
 		<< "\t#set output sprintf('%s.eps', file)" << '\n'
 		<< "\tplot \\" << '\n'
-		<< "\t\tfile i 0 u 1:3 w points t columnheader(1), \\" << '\n'
-		<< "\t\tfile i 1 u 1:3 w points t columnheader(1), \\" << '\n'
-		<< "\t\tfile i 2 u 1:3 w points t columnheader(1), \\" << '\n'
-		<< "\t\tfile i 3 u 1:3 w points t columnheader(1)" << '\n'
+		<< "\t\tfile i 0 u " << columns << " t columnheader(1), \\" << '\n'
+		<< "\t\tfile i 1 u " << columns << " t columnheader(1), \\" << '\n'
+		<< "\t\tfile i 2 u " << columns << " t columnheader(1), \\" << '\n'
+		<< "\t\tfile i 3 u " << columns << " t columnheader(1)" << '\n'
 		<< "}" << '\n'
 		<< std::endl;
 
@@ -181,6 +486,68 @@ void TraceVisualizer::makeInjPlot(std::string dirname)
 	}
 }
 
+void TraceVisualizer::writeInjData(std::ostream &out, const std::vector<InjData> &data)
+{
+	const auto& sep = gnuplot_seperator;
+
+	out << "# time_absolute" << sep << "time_relative" << sep << "bytes" << "\n";
+
+	// dummy value for the gnuplot script
+	if (data.empty())
+		out << 0.0 << sep << 0.0 << sep << 0 << "\n";
+
+	for (const auto &z:data)
+		out << z.time_absolute << sep << z.time_relative << sep << z.bytes << "\n";
+}
+
+void TraceVisualizer::writeInjBins(std::ostream &out, const std::vector<InjBin> &bins)
+{
+	const auto& sep = gnuplot_seperator;
+	const double runtime = stats->getApplicationTime();
+
+	out << "# time_absolute" << sep << "time_relative" << sep << "count" << sep << "bytes" << sep << "min_bytes" << sep << "max_bytes" << "\n";
+
+	// bins are written with their start time, empty ones are left out
+	bool empty = true;
+	for (size_t i=0; i<bins.size(); i++)
+	{
+		const auto &b = bins[i];
+		if (b.count == 0)
+			continue;
+
+		const double rel = static_cast<double>(i) / bins.size();
+		out << runtime * rel << sep << rel << sep << b.count << sep << b.bytes << sep << b.min << sep << b.max << "\n";
+		empty = false;
+	}
+
+	// dummy value for the gnuplot script
+	if (empty)
+		out << 0.0 << sep << 0.0 << sep << 0 << sep << 0 << sep << 0 << sep << 0 << "\n";
+}
+
+void TraceVisualizer::writeCdfData(std::ostream &out, const SizeHistogram &sizes)
+{
+	const auto& sep = gnuplot_seperator;
+
+	// dummy value for the gnuplot script in case of
+	// the absence of the respective message type
+	if (sizes.empty())
+	{
+		out << 1 << sep << 1 << sep << 1 << "\n";
+		return;
+	}
+
+	// CDF-ify data, a log bucket is plotted at its largest size
+	const auto total = static_cast<double>(sizes.count());
+	double last = 0.0;
+	sizes.forEach([&out, &sep, &last, total](uint64_t, uint64_t upper, uint64_t count)
+	{
+		auto perc = static_cast<double>(count) / total + last;
+		last = perc;
+		out << upper << sep << count << sep << perc << "\n";
+	});
+}
+
 void TraceVisualizer::makeCdfPlot(std::string dirname)
 {
 	std::map<MsgType, std::string> msg_type;
@@ -190,7 +557,6 @@ void TraceVisualizer::makeCdfPlot(std::string dirname)
 	const auto& sep = gnuplot_seperator;
 
 	// per node
-	std::map<uint64_t, uint64_t> all {};
 	for (auto x:messages_cdf)
 	{
 		auto proc = x.first;
@@ -198,36 +564,14 @@ void TraceVisualizer::makeCdfPlot(std::string dirname)
 		filename << dirname << "/" << gnuplot_cdf_filename_prefix << std::setw(procEnumFill) << std::setfill('0') << proc << ".csv";
 		std::ofstream out(filename.str(), std::ofstream::out);
 
-		// set dummy values for gnuplot script in case of
-		// the absence of the respective message type
-		if (x.second[COLL].empty())
-			x.second[COLL][1] = 1;
-
-		if (x.second[P2P].empty())
-			x.second[P2P][1] = 1;
-
-		for (auto y:x.second)
+		for (auto type:{P2P, COLL})
 		{
 			// section header
-			auto type = y.first;
 			out << "\"" << msg_type[type] << "\"" << '\n';
 			out << "# trace=" << config->tracename << ", node=" << proc << '\n';
 			out << "# size" << sep << "occurences" << sep << "percentage" << "\n";
 
-			// CDF-ify data
-			uint64_t total = 0;
-			for (auto l:y.second)
-				total += l.second;
-
-			double last = 0.0;
-			for (auto l:y.second)
-			{
-				auto size = l.first;
-				auto occu = l.second;
-				auto perc = static_cast<double>(occu) / static_cast<double>(total) + last;
-				last = perc;
-				out << size << sep << occu << sep << perc << "\n";
-			}
+			writeCdfData(out, x.second[type]);
 
 			// next data section
 			out << "\n\n";
@@ -242,7 +586,7 @@ void TraceVisualizer::makeCdfPlot(std::string dirname)
 	filename << dirname << "/" << "cdf-pAll.csv";
 	std::ofstream out(filename.str(), std::ofstream::out);
 
-	for (auto y:messages_cdf_allnodes)
+	for (const auto &y:messages_cdf_allnodes)
 	{
 		// section header
 		auto type = y.first;
@@ -250,20 +594,7 @@ void TraceVisualizer::makeCdfPlot(std::string dirname)
 		out << "# trace=" << config->tracename << ", node=" << "All" << '\n';
 		out << "# size" << sep << "occurences" << sep << "percentage" << "\n";
 
-		// CDF-ify data
-		uint64_t total = 0;
-		for (auto l:y.second)
-			total += l.second;
-
-		double last = 0.0;
-		for (auto l:y.second)
-		{
-			auto size = l.first;
-			auto occu = l.second;
-			auto perc = static_cast<double>(occu) / static_cast<double>(total) + last;
-			last = perc;
-			out << size << sep << occu << sep << perc << "\n";
-		}
+		writeCdfData(out, y.second);
 
 		// next data section
 		out << "\n\n";
@@ -325,33 +656,41 @@ void TraceVisualizer::makeCdfPlot(std::string dirname)
 	}
 }
 
-inline void TraceVisualizer::updateInactPeriods(uint32_t proc, uint64_t time)
-{
-	auto inactivity = time - lastActivity[proc];
-	lastActivity[proc] = time;
-	inactivity_periods[proc].push_back(inactivity);
-}
-
 void TraceVisualizer::makeInactivityHistogram(std::string dirname)
 {
-	for (auto x:inactivity_periods)
+	const size_t bins = inactivity_edges.size() - 1;
+
+	for (const auto &x:inactivity)
 	{
 		auto proc = x.first;
-		//std::cout << "proc=" << proc << std::endl;
+		const auto &counts = x.second;
 
 		std::stringstream filename;
 		filename << dirname << "/" << gnuplot_iahist_filename_prefix << std::setw(procEnumFill) << std::setfill('0') << proc << ".csv";
 		std::ofstream out(filename.str(), std::ofstream::out);
 
+		out << "# below " << inactivity_edges.front() / 1e3 << " us: " << counts.front() << '\n';
+		out << "# above " << inactivity_edges.back() / 1e3 << " us: " << counts.back() << '\n';
+		out << "lower_us upper_us count" << '\n';
+		for (size_t i=0; i<bins; i++)
+			out << inactivity_edges[i] / 1e3 << ' ' << inactivity_edges[i+1] / 1e3 << ' ' << counts[i+1] << '\n';
+		out << std::flush;
+
+		out.close();
+	}
+
+	// every single period, only for small traces
+	for (const auto &x:inactivity_periods)
+	{
+		std::stringstream filename;
+		filename << dirname << "/" << gnuplot_iaraw_filename_prefix << std::setw(procEnumFill) << std::setfill('0') << x.first << ".csv";
+		std::ofstream out(filename.str(), std::ofstream::out);
+
 		for (auto y:x.second)
-		{
-			auto inactPeriod = stats->toNanoS(y);
-			out << inactPeriod << '\n';
-		}
+			out << stats->toNanoS(y) << '\n';
 		out << std::flush;
 
 		out.close();
-		filename.str(std::string()); // clear stringstream
 	}
 
 	std::string gnuplot_scriptfile = "plot_iahist.R";
@@ -366,11 +705,11 @@ void TraceVisualizer::makeInactivityHistogram(std::string dirname)
 		<< "for (f in csvfiles)" << '\n'
 		<< "{" << '\n'
 		<< "print(paste0('f=', f))" << '\n'
-		<< "d <- read.csv(file=f, head=F, sep=' ', comment.char = '#')" << '\n'
-		<< "d <- d/1e3 # to us" << '\n'
-		<< "d<-subset(d, V1<500) # range of the histogram" << '\n'
+		<< "d <- read.csv(file=f, head=T, sep=' ', comment.char = '#')" << '\n'
 		<< '\n'
-		<< "plot=qplot(V1, data=d, geom='histogram', bins=50, xlab = 'Inactivity [us]', main = 'Node Inactivity')" << '\n'
+		<< "plot=ggplot(d) + geom_rect(aes(xmin=lower_us, xmax=upper_us, ymin=0, ymax=count))"
+		<< (config->iahist_log ? " + scale_x_log10()" : "")
+		<< " + labs(x='Inactivity [us]', y='count', title='Node Inactivity')" << '\n'
 		<< "ggsave(plot, file=paste0(f, '.pdf'))" << '\n'
 		<< "}" << '\n'
 		<< std::endl;
@@ -394,3 +733,253 @@ void TraceVisualizer::makeInactivityHistogram(std::string dirname)
 			std::cout << " done. " << std::endl;
 	}
 }
+
+void TraceVisualizer::makeCounterPlot(std::string dirname)
+{
+	const auto &names = stats->getPapiNames();
+	if (config->ctr_bins == 0 || names.empty() || counter_series.empty())
+		return;
+
+	const auto& sep = gnuplot_seperator;
+	const double runtime = stats->getApplicationTime();
+
+	// one file per process with a data section per PAPI counter
+	for (const auto &x:counter_series)
+	{
+		auto proc = x.first;
+		std::stringstream filename;
+		filename << dirname << "/" << gnuplot_ctr_filename_prefix << std::setw(procEnumFill) << std::setfill('0') << proc << ".csv";
+		std::ofstream out(filename.str(), std::ofstream::out);
+
+		for (size_t slot=0; slot<names.size(); slot++)
+		{
+			// section header
+			out << "\"" << names[slot] << "\"" << '\n';
+			out << "# trace=" << config->tracename << ", node=" << proc << '\n';
+			out << "# time_absolute" << sep << "time_relative" << sep << "rate_avg" << sep << "rate_min" << sep << "rate_max" << "\n";
+
+			// rates per second, bins with their start time, empty ones are left out
+			bool empty = true;
+			if (slot < x.second.size())
+			{
+				const auto &bins = x.second[slot].bins;
+				for (size_t i=0; i<bins.size(); i++)
+				{
+					const auto &b = bins[i];
+					if (b.samples == 0)
+						continue;
+
+					const double rel = static_cast<double>(i) / bins.size();
+					const double avg = b.delta / stats->getAbsoluteTime(b.ticks);
+					out << runtime * rel << sep << rel << sep << avg << sep << b.min << sep << b.max << "\n";
+					empty = false;
+				}
+			}
+
+			// dummy value for the gnuplot script
+			if (empty)
+				out << 0.0 << sep << 0.0 << sep << 0 << sep << 0 << sep << 0 << "\n";
+
+			// next data section
+			out << "\n\n";
+		}
+
+		out.close();
+	}
+
+	std::string gnuplot_scriptfile = "plot_ctr.gnuplot";
+	if (config->verbose)
+		std::cout << "Writing Gnuplot Script ... " << std::flush;
+	std::ofstream gnuplot(dirname + "/" + gnuplot_scriptfile);
+	gnuplot
+		<< "#" << config->tracename << '\n'
+		<< "set terminal pngcairo size 800,600 enhanced font 'Arial-Bold,16'" << '\n'
+		<< "#set terminal postscript eps enhanced color font 'Arial-Bold,16'" << '\n'
+		<< "datafiles = system('ls " << gnuplot_ctr_filename_prefix << "*.csv')" << '\n'
+		<< "set datafile separator \"" << gnuplot_seperator << "\"" << '\n'
+		<< '\n'
+		<< "set xrange [0:]" << '\n'
+		<< "set autoscale y" << '\n'
+		<< "set logscale y" << '\n'
+		<< '\n'
+		<< "set format y '%1.1e'" << '\n'
+		<< '\n'
+		<< "set xlabel 'Application Runtime [seconds]'" << '\n'
+		<< "set ylabel 'Counter Rate [1/s]'" << '\n'
+		<< '\n'
+		<< "set key horiz out bot center" << '\n'
+		<< "set key font ',14' spacing 1.0 samplen 1" << '\n'
+		<< '\n'
+		<< "do for [file in datafiles] {" << '\n'
+		<< "\tset output sprintf('%s.png', file)" << '\n'
+		<< "\t#set output sprintf('%s.eps', file)" << '\n'
+		<< "\tplot for [i=0:" << names.size()-1 << "] file i i u 1:3:4:5 w yerrorbars t columnheader(1)" << '\n'
+		<< "}" << '\n'
+		<< std::endl;
+
+	if (config->verbose)
+		std::cout << " done. " << std::endl;
+
+	if (gnuplot_present)
+	{
+		if (config->verbose)
+			std::cout << "Invoking Gnuplot ... " << std::flush;
+
+		std::string gnuplot_command = "(cd " + dirname + " && " + "gnuplot " + gnuplot_scriptfile + ")";
+#ifdef DEBUG
+		std::cout << "\n### gnuplot cmd: " << gnuplot_command << std::endl;
+#endif
+		int ret = std::system(gnuplot_command.c_str());
+		if (ret != 0)
+			std::cout << "Error: gnuplot returned with non-zero (" << ret << ")" << std::endl;
+		else if (config->verbose)
+			std::cout << " done. " << std::endl;
+	}
+}
+
+void TraceVisualizer::addFileOperation(const FileOpTracker::Operation &op)
+{
+	IoDirection dir;
+	switch (op.op & OTF_FILEOP_BITS)
+	{
+		case OTF_FILEOP_READ:  dir = IO_READ;  break;
+		case OTF_FILEOP_WRITE: dir = IO_WRITE; break;
+		default: return;
+	}
+
+	// the timeline is always binned, 100 bins without --inj-bins
+	auto &bins = io_bins[op.proc][dir];
+	if (bins.empty())
+		bins.resize(config->inj_bins ? config->inj_bins : 100);
+	addInjection(bins, op.begin, op.bytes);
+}
+
+void TraceVisualizer::makeIoPlot(std::string dirname)
+{
+	std::map<IoDirection, std::string> type;
+	type[IO_READ] = "Read";
+	type[IO_WRITE] = "Write";
+
+	// one file per process with a data section per direction
+	for (auto &x:io_bins)
+	{
+		auto proc = x.first;
+		std::stringstream filename;
+		filename << dirname << "/" << gnuplot_io_filename_prefix << std::setw(procEnumFill) << std::setfill('0') << proc << ".csv";
+		std::ofstream out(filename.str(), std::ofstream::out);
+
+		for (auto dir:{IO_READ, IO_WRITE})
+		{
+			// section header
+			out << "\"" << type[dir] << "\"" << '\n';
+			out << "# trace=" << config->tracename << ", node=" << proc << '\n';
+			writeInjBins(out, x.second[dir]);
+
+			// next data section
+			out << "\n\n";
+		}
+
+		out.close();
+	}
+
+	if (io_bins.empty())
+		return;
+
+	std::string gnuplot_scriptfile = "plot_io.gnuplot";
+	if (config->verbose)
+		std::cout << "Writing Gnuplot Script ... " << std::flush;
+	std::ofstream gnuplot(dirname + "/" + gnuplot_scriptfile);
+	gnuplot
+		<< "#" << config->tracename << '\n'
+		<< "set terminal pngcairo size 800,600 enhanced font 'Arial-Bold,16'" << '\n'
+		<< "#set terminal postscript eps enhanced color font 'Arial-Bold,16'" << '\n'
+		<< "datafiles = system('ls " << gnuplot_io_filename_prefix << "*.csv')" << '\n'
+		<< "set datafile separator \"" << gnuplot_seperator << "\"" << '\n'
+		<< '\n'
+		<< "set xrange [0:]" << '\n'
+		<< "set autoscale y" << '\n'
+		<< "set logscale y" << '\n'
+		<< '\n'
+		<< "set format y '%1.1e'" << '\n'
+		<< '\n'
+		<< "set xlabel 'Application Runtime [seconds]'" << '\n'
+		<< "set ylabel 'I/O Operation Size [Bytes]'" << '\n'
+		<< '\n'
+		<< "set key horiz out bot center" << '\n'
+		<< "set key font ',14' spacing 1.0 samplen 1" << '\n'
+		<< '\n'
+		<< "do for [file in datafiles] {" << '\n'
+		<< "\tset output sprintf('%s.png', file)" << '\n'
+		<< "\t#set output sprintf('%s.eps', file)" << '\n'
+		<< "\tplot \\" << '\n'
+		<< "\t\tfile i 0 u 1:($4/$3):5:6 w yerrorbars t columnheader(1), \\" << '\n'
+		<< "\t\tfile i 1 u 1:($4/$3):5:6 w yerrorbars t columnheader(1)" << '\n'
+		<< "}" << '\n'
+		<< std::endl;
+
+	if (config->verbose)
+		std::cout << " done. " << std::endl;
+
+	if (gnuplot_present)
+	{
+		if (config->verbose)
+			std::cout << "Invoking Gnuplot ... " << std::flush;
+
+		std::string gnuplot_command = "(cd " + dirname + " && " + "gnuplot " + gnuplot_scriptfile + ")";
+#ifdef DEBUG
+		std::cout << "\n### gnuplot cmd: " << gnuplot_command << std::endl;
+#endif
+		int ret = std::system(gnuplot_command.c_str());
+		if (ret != 0)
+			std::cout << "Error: gnuplot returned with non-zero (" << ret << ")" << std::endl;
+		else if (config->verbose)
+			std::cout << " done. " << std::endl;
+	}
+}
+
+void TraceVisualizer::makeCommMatrixPlot(std::string dirname)
+{
+	// the dense tables exist for small traces only
+	if (stats->getNumProcesses() > 256)
+		return;
+
+	std::string gnuplot_scriptfile = "plot_comm_matrix.gnuplot";
+	if (config->verbose)
+		std::cout << "Writing Gnuplot Script ... " << std::flush;
+	std::ofstream gnuplot(dirname + "/" + gnuplot_scriptfile);
+	gnuplot
+		<< "#" << config->tracename << '\n'
+		<< "set terminal pngcairo size 800,600 enhanced font 'Arial-Bold,16'" << '\n'
+		<< "set datafile separator \"" << gnuplot_seperator << "\"" << '\n'
+		<< '\n'
+		<< "set xlabel 'Receiver'" << '\n'
+		<< "set ylabel 'Sender'" << '\n'
+		<< "set cblabel 'Bytes'" << '\n'
+		<< "set yrange [] reverse" << '\n'
+		<< '\n'
+		<< "do for [layer in 'p2p coll'] {" << '\n'
+		<< "\tset output sprintf('comm_matrix_%s.png', layer)" << '\n'
+		<< "\tset title sprintf('Communication Matrix (%s)', layer)" << '\n'
+		<< "\tplot sprintf('comm_matrix_%s.csv', layer) matrix rowheaders columnheaders with image notitle" << '\n'
+		<< "}" << '\n'
+		<< std::endl;
+
+	if (config->verbose)
+		std::cout << " done. " << std::endl;
+
+	if (gnuplot_present)
+	{
+		if (config->verbose)
+			std::cout << "Invoking Gnuplot ... " << std::flush;
+
+		std::string gnuplot_command = "(cd " + dirname + " && " + "gnuplot " + gnuplot_scriptfile + ")";
+#ifdef DEBUG
+		std::cout << "\n### gnuplot cmd: " << gnuplot_command << std::endl;
+#endif
+		int ret = std::system(gnuplot_command.c_str());
+		if (ret != 0)
+			std::cout << "Error: gnuplot returned with non-zero (" << ret << ")" << std::endl;
+		else if (config->verbose)
+			std::cout << " done. " << std::endl;
+	}
+}
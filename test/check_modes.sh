@@ -0,0 +1,45 @@
+#!/bin/bash
+# usage: check_modes.sh path/to/sonar path/to/trace.otf
+#
+# Runs all analyses serially and in the parallel, sliced, unsorted, pipelined
+# and cached modes, the results must equal the serial ones (plots excluded).
+set -e
+set -u
+set -o pipefail
+
+SONAR=$(cd $(dirname $1) && pwd)/$(basename $1)
+STUB=$(basename $2 .otf)
+WORK=$(pwd)/modes_$STUB
+OPTIONS="--cct --comm-matrix --wait-states --call-sites 10 --rma --file-io"
+
+# the cache goes next to the trace, keep it out of the source tree
+rm -rf $WORK
+mkdir -p $WORK/trace
+cp $(dirname $2)/$STUB.* $WORK/trace/
+
+function run {
+	local name=$1
+	shift
+	mkdir $WORK/$name
+	(cd $WORK/$name && $SONAR $OPTIONS "$@" $WORK/trace/$STUB.otf > stdout.txt)
+	mv $WORK/$name/${STUB}_SonarResults_* $WORK/$name/results
+}
+
+run serial
+run threads -t 4
+run slices -k 4
+run threads_slices -t 4 -k 4
+run unsorted -u -t 4
+run pipeline --pipeline
+run cache_write -c
+run cache_read -c -t 4
+
+status=0
+for name in threads slices threads_slices unsorted pipeline cache_write cache_read; do
+	if ! diff -r -x '*.png' $WORK/serial/results $WORK/$name/results; then
+		echo "results of $name differ from the serial run"
+		status=1
+	fi
+done
+
+exit $status
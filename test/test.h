@@ -0,0 +1,23 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <iostream>
+
+/*
+ * Minimal checks for the unit tests: a failed CHECK is reported and
+ * counted, the test returns TEST_RESULT from main().
+ */
+static int test_failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) \
+		{ \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #cond << std::endl; \
+			test_failures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT (test_failures == 0 ? 0 : 1)
+
+#endif
@@ -0,0 +1,85 @@
+#include <vector>
+#include <test.h>
+#include <call_tree.h>
+
+// more children than fit into the node and its first overflow blocks
+static void manyChildren(void)
+{
+	const uint32_t n = 40;
+	CallTree t;
+	const uint32_t root = t.base(0);
+
+	std::vector<uint32_t> nodes;
+	for (uint32_t f=0; f<n; f++)
+		nodes.push_back(t.child(root, f));
+
+	// every function got its own node, a second lookup finds it
+	CHECK(t.size() == n + 1);
+	for (uint32_t f=0; f<n; f++)
+	{
+		CHECK(t.child(root, f) == nodes[f]);
+		CHECK(t.node(nodes[f]).func == f);
+		CHECK(t.node(nodes[f]).parent == root);
+	}
+	CHECK(t.size() == n + 1);
+
+	uint32_t seen = 0;
+	t.forEachChild(root, [&](uint32_t c) { CHECK(t.node(c).func == seen); seen++; });
+	CHECK(seen == n);
+}
+
+// overflow blocks of several nodes allocated in turn
+static void interleavedChildren(void)
+{
+	const uint32_t n = 30;
+	CallTree t;
+	const uint32_t root = t.base(0);
+	const uint32_t a = t.child(root, 1000);
+	const uint32_t b = t.child(root, 1001);
+
+	for (uint32_t f=0; f<n; f++)
+	{
+		t.child(a, f);
+		t.child(b, f);
+	}
+	CHECK(t.size() == 3 + 2*n);
+
+	for (auto p:{a, b})
+	{
+		uint32_t seen = 0;
+		t.forEachChild(p, [&](uint32_t c) { CHECK(t.node(c).parent == p); seen++; });
+		CHECK(seen == n);
+		for (uint32_t f=0; f<n; f++)
+			CHECK(t.node(t.child(p, f)).func == f);
+	}
+	CHECK(t.size() == 3 + 2*n);
+}
+
+static void graft(void)
+{
+	CallTree a, b;
+	const uint32_t ra = a.base(0);
+	const uint32_t rb = b.base(0);
+	for (uint32_t f=0; f<20; f++)
+	{
+		const uint32_t c = b.child(rb, f);
+		b.node(c).calls = f + 1;
+		b.node(b.child(c, 100)).calls = 1;
+	}
+	a.node(a.child(ra, 3)).calls = 10;
+
+	std::vector<uint32_t> map;
+	a.graft(ra, b, rb, map);
+	CHECK(a.node(a.child(ra, 3)).calls == 14);
+	CHECK(a.node(a.child(ra, 19)).calls == 20);
+	CHECK(a.node(a.child(a.child(ra, 7), 100)).calls == 1);
+	CHECK(a.size() == 1 + 20 + 20);
+}
+
+int main(void)
+{
+	manyChildren();
+	interleavedChildren();
+	graft();
+	return TEST_RESULT;
+}
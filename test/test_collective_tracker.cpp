@@ -0,0 +1,124 @@
+#include <memory>
+#include <vector>
+#include <test.h>
+#include <collective_tracker.h>
+
+using Instance = CollectiveTracker::Instance;
+
+static std::shared_ptr<TokenIndex> procs(uint32_t n)
+{
+	auto idx = std::make_shared<TokenIndex>();
+	for (uint32_t p=1; p<=n; p++)
+		idx->add(p);
+	return idx;
+}
+
+// an instance is handed over once all members have left
+static void complete(void)
+{
+	CollectiveTracker t(procs(4));
+	std::vector<Instance> got;
+	t.subscribe([&](const Instance &i) { got.push_back(i); });
+
+	for (uint64_t id=0; id<1000; id++)
+		for (uint32_t p=1; p<=4; p++)
+		{
+			t.addBegin(p, id * 10 + p, id, 1, 2, 4);
+			if (p == 4)
+				for (uint32_t q=1; q<=4; q++)
+					t.addEnd(q, id * 10 + 5, id);
+		}
+
+	CHECK(got.size() == 1000);
+	CHECK(got[0].participants.size() == 4 && got[0].participants[3].enter == 4);
+	CHECK(t.unfinishedInstances() == 0 && t.unmatchedEnds() == 0);
+}
+
+// a part starting inside an instance resolves its ends when merged
+static void mergedParts(void)
+{
+	auto idx = procs(2);
+	CollectiveTracker a(idx), b(idx);
+	uint64_t done = 0;
+	a.subscribe([&](const Instance &i) { CHECK(i.participants.size() == 2); done++; });
+
+	a.addBegin(1, 1, 7, 1, 0, 2);
+	a.addBegin(2, 2, 7, 1, 0, 2);
+	a.addEnd(1, 3, 7);
+	b.addEnd(2, 4, 7);  // entered in a
+	b.addBegin(1, 5, 8, 1, 0, 2);
+	b.addEnd(1, 6, 8);
+	CHECK(b.unmatchedEnds() == 1);
+
+	a.merge(b);
+	CHECK(done == 1);
+	CHECK(a.unfinishedInstances() == 1);
+	a.addBegin(2, 7, 8, 1, 0, 2);
+	a.addEnd(2, 8, 8);
+	CHECK(done == 2);
+	CHECK(a.unfinishedInstances() == 0 && a.unmatchedEnds() == 0);
+}
+
+// unknown communicator size: handed over by finish()
+static void finish(void)
+{
+	CollectiveTracker t(procs(2));
+	uint64_t done = 0;
+	t.subscribe([&](const Instance &) { done++; });
+	t.addBegin(1, 1, 3, 9, 0, 0);
+	t.addEnd(1, 2, 3);
+	t.addBegin(2, 1, 4, 9, 0, 0);
+	CHECK(done == 0);
+	t.finish();
+	CHECK(done == 1);
+	CHECK(t.unfinishedInstances() == 1);
+}
+
+// stream shards hand the parts of their processes to the merge
+static void ownedParts(void)
+{
+	auto idx = procs(4);
+	CollectiveTracker main(idx), a(idx), b(idx);
+	std::vector<Instance> got;
+	main.subscribe([&](const Instance &i) { got.push_back(i); });
+	uint64_t in_shard = 0;
+	b.subscribe([&](const Instance &) { in_shard++; });
+
+	a.own({{1, 2}});
+	b.own({{1, 2}, {2, 2}});
+	for (uint64_t id=0; id<100; id++)
+	{
+		a.addBegin(1, id, id, 1, 0, 4);
+		a.addBegin(2, id, id, 1, 0, 4);
+		a.addEnd(1, id + 1, id);
+		a.addEnd(2, id + 1, id);
+		b.addBegin(3, id, id, 1, 0, 4);
+		b.addBegin(4, id, id, 1, 0, 4);
+		b.addEnd(3, id + 2, id);
+		b.addEnd(4, id + 2, id);
+		b.addBegin(3, id, 1000 + id, 2, 0, 2);
+		b.addBegin(4, id, 1000 + id, 2, 0, 2);
+		b.addEnd(3, id + 1, 1000 + id);
+		b.addEnd(4, id + 1, 1000 + id);
+	}
+	a.addBegin(1, 200, 500, 1, 0, 4); // left open
+
+	// only the shard's part of the instances is kept
+	CHECK(a.unfinishedInstances() == 1 && b.unfinishedInstances() == 0);
+	CHECK(in_shard == 100);
+
+	main.merge(a);
+	main.merge(b);
+	CHECK(got.size() == 100);
+	CHECK(got[0].participants.size() == 4);
+	CHECK(main.unfinishedInstances() == 1);
+}
+
+int main(void)
+{
+	complete();
+	mergedParts();
+	finish();
+	ownedParts();
+	return TEST_RESULT;
+}
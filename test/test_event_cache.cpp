@@ -0,0 +1,78 @@
+#include <fstream>
+#include <cstdlib>
+#include <test.h>
+#include <event_cache.h>
+
+static std::string scratch(void)
+{
+	char tmpl[] = "/tmp/sonar-test-XXXXXX";
+	return mkdtemp(tmpl);
+}
+
+// events written per process come back in order from the mapped files
+static void roundTrip(void)
+{
+	const std::string base = scratch();
+	const std::string otffile = base + "/trace.otf";
+	std::ofstream(otffile) << "master control";
+	std::ofstream(base + "/trace.0.events") << "stream";
+
+	const std::string dir = EventCache::location(otffile);
+	CHECK(dir == base + "/trace.sonar-cache");
+	CHECK(EventCache::prepare(dir + ".tmp"));
+
+	const uint64_t n = 3 * EventCache::block_size + 17; // more than one block
+	std::map<uint32_t, uint64_t> written;
+	{
+		EventCache cache(dir + ".tmp");
+		for (uint64_t i=0; i<n; i++)
+		{
+			cache.addEnter(1, i, 7, 1);
+			cache.addSend(2, 2 * i, 1, 3, 4, i % 1000, 5);
+		}
+		cache.addEndCollop(3, 99, 0x123456789ULL);
+		written = cache.close();
+		CHECK(cache.ok());
+	}
+	CHECK(written.size() == 3 && written[1] == n && written[3] == 1);
+
+	CHECK(!EventCache::isValid(dir, otffile));
+	CHECK(EventCache::commit(dir + ".tmp", dir, otffile, 12345, written));
+	CHECK(EventCache::isValid(dir, otffile));
+	CHECK(EventCache::events(dir) == 12345);
+	CHECK(EventCache::processes(dir) == std::vector<uint32_t>({1, 2, 3}));
+
+	{
+		EventCache::Mapping map(EventCache::filename(dir, 2));
+		CHECK(map.process == 2);
+		uint64_t i = 0;
+		for (const auto &col:map.blocks)
+			for (uint64_t k=0; k<col.n; k++, i++)
+				if (col.kind[k] != SEND || col.time[k] != 2 * i || col.a[k] != 1 || col.b[k] != 3 || col.c[k] != 4 || col.v[k] != i % 1000 || col.s[k] != 5)
+				{
+					CHECK(false);
+					return;
+				}
+		CHECK(i == n);
+	}
+	{
+		EventCache::Mapping map(EventCache::filename(dir, 3));
+		CHECK(map.blocks.size() == 1 && map.blocks[0].n == 1);
+		CHECK(map.blocks[0].kind[0] == END_COLLOP && map.blocks[0].m[0] == 0x123456789ULL);
+	}
+
+	// a changed stream file invalidates the cache
+	std::ofstream(base + "/trace.0.events", std::ofstream::app) << "more events";
+	CHECK(!EventCache::isValid(dir, otffile));
+
+	EventCache::remove(dir);
+	std::remove((base + "/trace.0.events").c_str());
+	std::remove(otffile.c_str());
+	rmdir(base.c_str());
+}
+
+int main(void)
+{
+	roundTrip();
+	return TEST_RESULT;
+}
@@ -0,0 +1,51 @@
+#include <vector>
+#include <test.h>
+#include <file_op_tracker.h>
+
+using Operation = FileOpTracker::Operation;
+
+static void pairs(void)
+{
+	FileOpTracker t;
+	std::vector<Operation> got;
+	t.subscribe([&](const Operation &op) { got.push_back(op); });
+
+	// the same matching id on two processes
+	t.addBegin(1, 10, 5);
+	t.addBegin(2, 11, 5);
+	t.addEnd(2, 20, 5, 3, 1, 100);
+	t.addEnd(1, 30, 5, 3, 2, 200);
+	t.addOperation(1, 40, 45, 3, 0, 0);
+
+	CHECK(got.size() == 3);
+	CHECK(got[0].proc == 2 && got[0].begin == 11 && got[0].end == 20 && got[0].bytes == 100);
+	CHECK(got[1].proc == 1 && got[1].begin == 10 && got[1].end == 30);
+	CHECK(got[2].begin == 40 && got[2].end == 45);
+	CHECK(t.pendingBegins() == 0 && t.unmatchedEnds() == 0);
+}
+
+static void mergedParts(void)
+{
+	FileOpTracker a, b;
+	uint64_t done = 0;
+	a.subscribe([&](const Operation &op) { CHECK(op.begin < op.end); done++; });
+
+	for (uint64_t id=0; id<2000; id++)
+		a.addBegin(1 + id % 4, id, id);
+	for (uint64_t id=0; id<1000; id++)
+		b.addEnd(1 + id % 4, 5000 + id, id, 1, 2, 8);
+	b.addBegin(1, 9000, 99999);
+	b.addEnd(1, 9001, 123456, 1, 2, 8); // never begun
+
+	a.merge(b);
+	CHECK(done == 1000);
+	CHECK(a.pendingBegins() == 1001);
+	CHECK(a.unmatchedEnds() == 1);
+}
+
+int main(void)
+{
+	pairs();
+	mergedParts();
+	return TEST_RESULT;
+}
@@ -0,0 +1,63 @@
+#include <map>
+#include <random>
+#include <test.h>
+#include <flat_hash_map.h>
+
+struct IdHash {
+	uint64_t operator()(uint64_t id) const { return mix64(id); }
+};
+
+// random inserts and erases against std::map, many wrap around the table
+static void againstMap(void)
+{
+	FlatHashMap<uint64_t, uint64_t, IdHash> m(16);
+	std::map<uint64_t, uint64_t> ref;
+	std::mt19937_64 rng(42);
+
+	for (int i=0; i<200000; i++)
+	{
+		const uint64_t k = rng() % 5000;
+		if (rng() % 3 == 0)
+		{
+			CHECK(m.erase(k) == (ref.erase(k) == 1));
+		}
+		else
+		{
+			m[k] += i;
+			ref[k] += i;
+		}
+	}
+
+	CHECK(m.size() == ref.size());
+	for (const auto &r:ref)
+	{
+		const uint64_t *v = m.get(r.first);
+		CHECK(v != nullptr && *v == r.second);
+	}
+
+	size_t n = 0;
+	m.forEach([&](uint64_t k, uint64_t v) { CHECK(ref.count(k) && ref[k] == v); n++; });
+	CHECK(n == ref.size());
+
+	for (uint64_t k=5000; k<5100; k++)
+		CHECK(m.get(k) == nullptr);
+}
+
+static void eraseAll(void)
+{
+	FlatHashMap<uint64_t, int, IdHash> m;
+	for (uint64_t k=0; k<1000; k++)
+		m[k] = 1;
+	for (uint64_t k=0; k<1000; k++)
+		CHECK(m.erase(k));
+	CHECK(m.empty());
+	CHECK(!m.erase(0));
+	CHECK(m.get(7) == nullptr);
+}
+
+int main(void)
+{
+	againstMap();
+	eraseAll();
+	return TEST_RESULT;
+}
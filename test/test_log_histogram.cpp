@@ -0,0 +1,90 @@
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <test.h>
+#include <log_histogram.h>
+
+// every value lies in its bucket, buckets are at most 1/2^sub_bits wide
+static void buckets(void)
+{
+	LogHistogram h;
+	std::vector<uint64_t> values {0, 1, 31, 32, 33, 63, 64, 1000, 1u << 20, (1ull << 40) + 12345, ~0ull};
+	for (auto v:values)
+		h.add(v);
+	CHECK(h.count() == values.size());
+
+	uint64_t n = 0, prev = 0;
+	bool first = true;
+	h.forEach([&](uint64_t lo, uint64_t hi, uint64_t)
+	{
+		CHECK(lo <= hi);
+		CHECK(first || lo > prev);
+		if (lo >= 32)
+			CHECK(hi - lo < lo / 32 + 1);
+		for (auto v:values)
+			if (v >= lo && v <= hi)
+				n++;
+		prev  = hi;
+		first = false;
+	});
+	CHECK(n == values.size());
+
+	LogHistogram e;
+	CHECK(e.empty() && e.quantile(0.5) == 0);
+}
+
+// quantiles stay within the bucket error of the exact ones
+static void quantiles(void)
+{
+	LogHistogram h;
+	std::vector<uint64_t> values;
+	std::mt19937_64 rng(3);
+	for (int i=0; i<20000; i++)
+	{
+		const uint64_t v = rng() >> (rng() % 60);
+		values.push_back(v);
+		h.add(v);
+	}
+	std::sort(values.begin(), values.end());
+
+	for (double q:{0.01, 0.25, 0.5, 0.9, 0.999, 1.0})
+	{
+		const uint64_t exact = values[static_cast<size_t>(std::ceil(q * values.size())) - 1];
+		const uint64_t got   = h.quantile(q);
+		const uint64_t err   = exact / 32 + 1;
+		CHECK((got > exact ? got - exact : exact - got) <= err);
+	}
+}
+
+// merging gives the same buckets regardless of how the values were split
+static void merging(void)
+{
+	LogHistogram all, a, b, c;
+	std::mt19937_64 rng(5);
+	for (int i=0; i<5000; i++)
+	{
+		const uint64_t v = rng() >> (rng() % 64);
+		all.add(v);
+		(v < 1000 ? a : (v < (1ull << 40) ? b : c)).add(v);
+	}
+
+	LogHistogram m;
+	m.merge(c);
+	m.merge(LogHistogram());
+	m.merge(a);
+	m.merge(b);
+	CHECK(m.count() == all.count());
+
+	std::vector<uint64_t> x, y;
+	all.forEach([&x](uint64_t lo, uint64_t hi, uint64_t n) { x.insert(x.end(), {lo, hi, n}); });
+	m.forEach([&y](uint64_t lo, uint64_t hi, uint64_t n) { y.insert(y.end(), {lo, hi, n}); });
+	CHECK(x == y);
+}
+
+int main(void)
+{
+	buckets();
+	quantiles();
+	merging();
+	return TEST_RESULT;
+}
@@ -0,0 +1,90 @@
+#include <vector>
+#include <test.h>
+#include <message_matcher.h>
+
+using Match = MessageMatcher::Match;
+
+// n-th send of a channel pairs with its n-th receive, in any interleaving
+static void fifoPerChannel(void)
+{
+	MessageMatcher m;
+	std::vector<Match> got;
+	m.subscribe([&](const Match &x) { got.push_back(x); });
+
+	m.addRecv(5, 2, 1, 0, 7, 100);
+	m.addSend(1, 1, 2, 0, 7, 100);
+	m.addSend(2, 1, 2, 0, 7, 200);
+	m.addSend(3, 1, 2, 0, 8, 300); // other tag
+	m.addRecv(6, 2, 1, 0, 8, 300);
+	m.addRecv(7, 2, 1, 0, 7, 200);
+
+	CHECK(got.size() == 3);
+	CHECK(got[0].send_time == 1 && got[0].recv_time == 5 && got[0].length == 100);
+	CHECK(got[1].send_time == 3 && got[1].recv_time == 6);
+	CHECK(got[2].send_time == 2 && got[2].recv_time == 7 && got[2].length == 200);
+	CHECK(m.pendingSends() == 0 && m.pendingRecvs() == 0);
+}
+
+// shards of consecutive parts give the matches of a single instance
+static void mergedShards(void)
+{
+	MessageMatcher whole;
+	MessageMatcher main;
+	std::vector<MessageMatcher> parts(3, MessageMatcher(true));
+	uint64_t n_whole = 0, n_main = 0;
+	whole.subscribe([&](const Match &) { n_whole++; });
+	main.subscribe([&](const Match &) { n_main++; });
+
+	for (uint32_t i=0; i<300; i++)
+	{
+		const uint32_t s = i % 5, r = (i + 1) % 5;
+		whole.addSend(i, s, r, 0, i % 3, i);
+		parts[i / 100].addSend(i, s, r, 0, i % 3, i);
+		whole.addRecv(i + 150, r, s, 0, i % 3, i);
+		parts[std::min<uint32_t>(2, (i + 150) / 100)].addRecv(i + 150, r, s, 0, i % 3, i);
+	}
+	whole.addSend(1000, 9, 8, 0, 0, 1);
+
+	for (const auto &p:parts)
+		main.merge(p);
+	main.addSend(1000, 9, 8, 0, 0, 1);
+
+	CHECK(n_whole == 300 && n_main == 300);
+	CHECK(main.pendingSends() == whole.pendingSends());
+	CHECK(main.pendingRecvs() == whole.pendingRecvs());
+	CHECK(main.pendingSends() == 1);
+}
+
+// a shard matches the channels between the processes it owns right away
+static void ownedProcesses(void)
+{
+	MessageMatcher shard(true);
+	uint64_t n = 0;
+	shard.subscribe([&](const Match &) { n++; });
+
+	shard.own(1);
+	shard.addRecv(5, 1, 2, 0, 0, 8);   // 2 not owned yet
+	shard.addSend(6, 1, 3, 0, 0, 8);   // 3 is read elsewhere
+	CHECK(n == 0);
+
+	shard.own(2);
+	shard.addSend(1, 2, 1, 0, 0, 8);
+	shard.addSend(2, 2, 1, 0, 0, 8);
+	CHECK(n == 1);
+	CHECK(shard.pendingSends() == 2 && shard.pendingRecvs() == 0);
+
+	MessageMatcher main;
+	main.subscribe([&](const Match &) { n++; });
+	main.merge(shard);
+	main.addRecv(7, 3, 1, 0, 0, 8);
+	CHECK(n == 2);
+	CHECK(main.pendingSends() == 1);
+}
+
+int main(void)
+{
+	fifoPerChannel();
+	mergedShards();
+	ownedProcesses();
+	return TEST_RESULT;
+}
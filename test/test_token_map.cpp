@@ -0,0 +1,87 @@
+#include <map>
+#include <random>
+#include <test.h>
+#include <token_map.h>
+
+// tokens in the index and outside of it iterate in token order like std::map
+static void likeStdMap(void)
+{
+	auto idx = std::make_shared<TokenIndex>();
+	for (uint32_t t=100; t>0; t--)
+		idx->add(t * 7);
+	idx->add(1u << 30); // sparse
+
+	TokenMap<uint64_t> m(idx);
+	std::map<uint32_t, uint64_t> ref;
+	std::mt19937 rng(1);
+	for (int i=0; i<5000; i++)
+	{
+		const uint32_t t = (rng() % 2) ? (rng() % 100 + 1) * 7 : rng() % 1000;
+		m[t] += i;
+		ref[t] += i;
+
+		if (i % 500 == 0)
+		{
+			auto r = ref.begin();
+			for (const auto &e:m)
+			{
+				CHECK(r != ref.end() && e.first == r->first && e.second == r->second);
+				++r;
+			}
+			CHECK(r == ref.end());
+		}
+	}
+	m[1u << 30] = 1;
+	ref[1u << 30] = 1;
+
+	CHECK(m.size() == ref.size());
+	CHECK(m.count(7) == ref.count(7) && m.count(1u << 30) == 1 && m.count(3) == ref.count(3));
+
+	const TokenMap<uint64_t> &c = m;
+	auto r = ref.begin();
+	for (const auto &e:c)
+		CHECK(e.first == (r++)->first);
+	CHECK(r == ref.end());
+}
+
+// copies iterate their own values
+static void copies(void)
+{
+	auto idx = std::make_shared<TokenIndex>();
+	idx->add(1);
+	idx->add(2);
+
+	TokenMap<int> a(idx);
+	a[2] = 2;
+	a[1] = 1;
+	a[5] = 5;
+	for (const auto &e:a)
+		CHECK(e.first == static_cast<uint32_t>(e.second));
+
+	TokenMap<int> b(a);
+	for (auto &e:b)
+		e.second = 0;
+	a[3] = 3;
+	int sum = 0;
+	for (const auto &e:a)
+		sum += e.second;
+	CHECK(sum == 11);
+
+	b = a;
+	a.clear();
+	CHECK(a.empty() && a.begin() == a.end());
+	sum = 0;
+	for (const auto &e:b)
+		sum += e.second;
+	CHECK(sum == 11 && b.size() == 4);
+
+	TokenMap<int> m(std::move(b));
+	CHECK(m.begin()->first == 1 && m.size() == 4);
+}
+
+int main(void)
+{
+	likeStdMap();
+	copies();
+	return TEST_RESULT;
+}